@@ -0,0 +1,131 @@
+//
+//
+//      fffb
+//      force/controller.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/joy/input.hxx>
+#include <fffb/force/telemetry.hxx>
+#include <fffb/force/shaping.hxx>
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// contributions of the last step, signed and normalized to [-1, 1] of full wheel torque.
+// positive pushes the same way the constant slot does above 128, which is also positive wheel position
+struct controller_terms
+{
+        float target { 0.0f } ;
+        float  error { 0.0f } ;
+        float center { 0.0f } ;
+        float damper { 0.0f } ;
+        float  total { 0.0f } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// closed loop centering and damping on the host, replacing the firmware spring and damper slots.
+// the target angle is where the game's steering is, pulled toward center with speed and offset by the
+// self-aligning moment from lateral acceleration. a pd loop on the measured wheel angle and velocity
+// drives the rim there, the output goes out through the constant slot every scheduler tick.
+// step() only runs the loop on a recent wheel sample, callers fall back to the firmware effects otherwise
+
+class torque_controller
+{
+public:
+        constexpr torque_controller () noexcept = default ;
+
+        constexpr void reset () noexcept { *this = torque_controller{} ; }
+
+        // true when _input_ is recent enough at _now_ for the loop to act on
+        [[ nodiscard ]] static constexpr bool usable ( wheel_input const & _input_, nanoseconds_t _now_ ) noexcept
+        { return _input_.timestamp != 0 && _now_ >= _input_.timestamp && _now_ - _input_.timestamp < max_input_age_ns ; }
+
+        // returns the constant slot amplitude for this tick
+        [[ nodiscard ]] constexpr uti::u8_t step ( telemetry_state const & _state_, wheel_input const & _input_ ) noexcept ;
+
+        [[ nodiscard ]] constexpr controller_terms const & terms () const noexcept { return terms_ ; }
+private:
+        controller_terms terms_ {} ;
+
+        // a wheel reports every few ms, anything older means the reader stalled
+        static constexpr nanoseconds_t max_input_age_ns { 20 * 1000 * 1000 } ;
+
+        // full torque at this much position error, in normalized wheel units
+        static constexpr float kp_full_error { 0.25f } ;
+
+        // damping per normalized unit/s of wheel velocity at full coefficient
+        static constexpr float kd_max { 0.12f } ;
+
+        // how far 1 m/s^2 of lateral acceleration moves the target, a lateral g sets it back ~25 degrees
+        static constexpr float sat_offset_gain { 0.0055f } ;
+        static constexpr float sat_offset_max  { 0.12f   } ;
+
+        // small dead zone around the target so we don't fight the player
+        static constexpr float deadband { 0.004f } ;
+
+        static constexpr float torque_max { 0.94f } ;
+
+        constexpr float _target  ( telemetry_state const & _state_, float _speed_ ) const noexcept ;
+        constexpr float _damping ( telemetry_state const & _state_, float _speed_ ) const noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr uti::u8_t torque_controller::step ( telemetry_state const & _state_, wheel_input const & _input_ ) noexcept
+{
+        float const speed = _state_.speed < 0.0f ? -_state_.speed : _state_.speed ;
+
+        terms_.target = _target( _state_, speed ) ;
+        terms_.error  = terms_.target - _input_.position ;
+
+        float const magnitude = terms_.error < 0.0f ? -terms_.error : terms_.error ;
+        float const past      = magnitude > deadband ? magnitude - deadband : 0.0f ;
+        float const error     = terms_.error < 0.0f ? -past : past ;
+
+        terms_.center = clampf( error / kp_full_error * centering_stiffness( speed ), -torque_max, torque_max ) ;
+        terms_.damper = clampf( -_input_.velocity * kd_max * _damping( _state_, speed ), -0.3f, 0.3f ) ;
+        terms_.total  = clampf( terms_.center + terms_.damper, -torque_max, torque_max ) ;
+
+        return static_cast< uti::u8_t >( clampf( 128.0f + terms_.total * 127.0f + 0.5f, 1.0f, 255.0f ) ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr float torque_controller::_target ( telemetry_state const & _state_, float const _speed_ ) const noexcept
+{
+        // parked the rim stays wherever the player left it, at speed it wants to return to center
+        float const authority = centering_stiffness( _speed_ ) ;
+
+        // the self-aligning moment leans the target toward the outside of the turn, eased off on heavy braking
+        float const speed_factor = clampf( _speed_ / 5.0f, 0.0f, 1.0f ) ;
+        float const brake_factor = _state_.brake > 0.7f ? 0.6f : 1.0f ;
+
+        float const sat = clampf( _state_.lateral_accel * sat_offset_gain * speed_factor * brake_factor, -sat_offset_max, sat_offset_max ) ;
+
+        return clampf( _state_.steering * ( 1.0f - authority ) + sat, -1.0f, 1.0f ) ;
+}
+
+// same coefficient as the damper slot's slope, out of its 3 bit maximum
+constexpr float torque_controller::_damping ( telemetry_state const & _state_, float const _speed_ ) const noexcept
+{
+        float coefficient = clampf( _speed_ / 10.0f * 5.0f, 2.0f, 6.0f ) ;
+
+        if( _state_.brake > 0.3f ) coefficient += 1.0f ;
+
+        return clampf( coefficient, 0.0f, 7.0f ) / 7.0f ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
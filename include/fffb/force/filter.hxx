@@ -0,0 +1,412 @@
+//
+//
+//      fffb
+//      force/filter.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/force/telemetry.hxx>
+#include <fffb/force/shaping.hxx>
+
+#include <cmath>
+
+// frames further apart than this are treated as a restart, filters settle on the new input instead of integrating the gap
+#define FFFB_FILTER_MAX_DT 0.25f
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// per-channel setup, a zero disables the stage for that channel.
+// stages run in declaration order: slew limiter, one euro, high-pass, low-pass
+
+struct filter_config
+{
+        float  slew_rate { 0.0f } ;   // max change per second
+        float min_cutoff { 0.0f } ;   // one euro cutoff at rest, Hz
+        float       beta { 0.0f } ;   // one euro cutoff increase per unit/s of speed
+        float   d_cutoff { 1.0f } ;   // one euro cutoff of the speed estimate, Hz
+        float  hp_cutoff { 0.0f } ;   // biquad high-pass, Hz
+        float  lp_cutoff { 0.0f } ;   // biquad low-pass, Hz
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a fixed block of channels filtered together over the time that actually passed between two samples.
+// everything is stored per stage as one array across channels so each stage is a flat loop the compiler can vectorize,
+// disabled stages are a select rather than a branch.
+// biquads are direct form I, which tolerates coefficients changing every sample as dt jitters
+
+template< uti::ssize_t N >
+class filter_block
+{
+public:
+        using config_table = uti::array< filter_config, N > ;
+
+        constexpr explicit filter_block ( config_table const & _config_ ) noexcept ;
+
+        // settles every stage on _in_, as if it had been constant forever
+        constexpr void reset ( float const * _in_ ) noexcept ;
+
+        constexpr void step ( float const * _in_, float _dt_ ) noexcept ;
+
+        [[ nodiscard ]] constexpr float const * output () const noexcept { return out_  ; }
+        [[ nodiscard ]] constexpr float const *   rate () const noexcept { return rate_ ; }
+private:
+        float  slew_rate_ [ N ] {} ;
+        float min_cutoff_ [ N ] {} ;
+        float       beta_ [ N ] {} ;
+        float   d_cutoff_ [ N ] {} ;
+        float  hp_cutoff_ [ N ] {} ;
+        float  lp_cutoff_ [ N ] {} ;
+
+        bool slew_on_ [ N ] {} ;
+        bool euro_on_ [ N ] {} ;
+        bool   hp_on_ [ N ] {} ;
+        bool   lp_on_ [ N ] {} ;
+
+        float slew_ [ N ] {} ;
+
+        float euro_x_  [ N ] {} ;
+        float euro_dx_ [ N ] {} ;
+
+        float hp_x1_ [ N ] {} ; float hp_x2_ [ N ] {} ; float hp_y1_ [ N ] {} ; float hp_y2_ [ N ] {} ;
+        float lp_x1_ [ N ] {} ; float lp_x2_ [ N ] {} ; float lp_y1_ [ N ] {} ; float lp_y2_ [ N ] {} ;
+
+        float  out_ [ N ] {} ;
+        float rate_ [ N ] {} ;
+
+        float scratch_ [ N ] {} ;
+
+        // butterworth
+        static constexpr float biquad_q { 0.70710678f } ;
+
+        // keeps a cutoff close to nyquist from folding over when frames get long
+        static constexpr float max_w0 { 0.95f * 3.14159265359f } ;
+
+        // smoothing factor of a first order low-pass with cutoff _fc_ over _dt_
+        static constexpr float _alpha ( float _fc_, float _dt_ ) noexcept
+        { return _dt_ / ( _dt_ + 1.0f / ( two_pi * _fc_ ) ) ; }
+
+        static constexpr float _abs ( float _v_ ) noexcept { return _v_ < 0.0f ? -_v_ : _v_ ; }
+
+        constexpr void _slew     ( float * _x_, float _dt_ ) noexcept ;
+        constexpr void _one_euro ( float * _x_, float _dt_ ) noexcept ;
+        constexpr void _highpass ( float * _x_, float _dt_ ) noexcept ;
+        constexpr void _lowpass  ( float * _x_, float _dt_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the telemetry channels the simulator reads through the filter
+
+enum class filtered_channel : uti::u8_t
+{
+        steering      ,
+        lateral_accel ,
+        deflection_l  ,
+        deflection_r  ,
+        count         ,
+} ;
+
+inline constexpr uti::ssize_t filtered_channel_count { static_cast< uti::ssize_t >( filtered_channel::count ) } ;
+
+inline constexpr filter_block< filtered_channel_count >::config_table telemetry_filter_config
+{
+        // steering: adaptive smoothing, steady hands get a low cutoff, fast corrections pass through
+        filter_config{ 0.0f, 4.0f, 0.5f, 1.0f, 0.0f, 0.0f },
+        // lateral acceleration: collisions can't yank the wheel in a single frame, then smooth the road noise out
+        filter_config{ 150.0f, 1.5f, 0.05f, 1.0f, 0.0f, 0.0f },
+        // suspension: drop the static load and slow body roll, keep bumps, trim frame-to-frame jitter
+        filter_config{ 0.0f, 0.0f, 0.0f, 1.0f, 0.5f, 20.0f },
+        filter_config{ 0.0f, 0.0f, 0.0f, 1.0f, 0.5f, 20.0f },
+} ;
+
+// a snapshot with the filtered channels written back, plus their rates over simulation time
+struct filtered_telemetry
+{
+        telemetry_state state {} ;
+
+        float     steering_rate { 0.0f } ;
+        float deflection_rate_l { 0.0f } ;
+        float deflection_rate_r { 0.0f } ;
+
+        // simulation time covered by the last filter step in seconds, zero after a reset
+        float dt { 0.0f } ;
+
+        // false when the snapshot is the same game frame the filter already consumed
+        bool fresh { false } ;
+
+        // telemetry_field bits of the filtered channels whose output moved in the last step,
+        // a filter keeps settling for a while after its raw input stopped changing
+        uti::u64_t changed { 0 } ;
+} ;
+
+// runs the filter block once per game frame, however often it's asked.
+// dt comes from raw_simulation_timestamp so the result doesn't depend on the game's or the tick's rate
+
+class telemetry_filter
+{
+public:
+        constexpr telemetry_filter () noexcept = default ;
+
+        constexpr filtered_telemetry const & update ( telemetry_state const & _state_ ) noexcept ;
+
+        [[ nodiscard ]] constexpr filtered_telemetry const & last () const noexcept { return out_ ; }
+private:
+        filter_block< filtered_channel_count > block_ { telemetry_filter_config } ;
+
+        filtered_telemetry out_ {} ;
+
+        uti::u64_t moved_last_ { 0 } ;
+
+        // outputs closer than this to the previous step count as settled
+        static constexpr float settled_epsilon { 1e-5f } ;
+
+        static constexpr telemetry_field channel_fields [ filtered_channel_count ]
+        {
+                telemetry_field::steering     ,
+                telemetry_field::acceleration ,
+                telemetry_field::deflection_l ,
+                telemetry_field::deflection_r ,
+        } ;
+
+        timestamp_t last_time_ { static_cast< timestamp_t >( -1 ) } ;
+
+        static constexpr uti::ssize_t _idx ( filtered_channel _channel_ ) noexcept { return static_cast< uti::ssize_t >( _channel_ ) ; }
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+template< uti::ssize_t N >
+constexpr filter_block< N >::filter_block ( config_table const & _config_ ) noexcept
+{
+        for( uti::ssize_t i = 0; i < N; ++i )
+        {
+                filter_config const & c = _config_[ i ] ;
+
+                 slew_rate_[ i ] = c. slew_rate ;
+                min_cutoff_[ i ] = c.min_cutoff ;
+                      beta_[ i ] = c.      beta ;
+                  d_cutoff_[ i ] = c.  d_cutoff ;
+                 hp_cutoff_[ i ] = c. hp_cutoff ;
+                 lp_cutoff_[ i ] = c. lp_cutoff ;
+
+                slew_on_[ i ] = c. slew_rate > 0.0f ;
+                euro_on_[ i ] = c.min_cutoff > 0.0f ;
+                  hp_on_[ i ] = c. hp_cutoff > 0.0f ;
+                  lp_on_[ i ] = c. lp_cutoff > 0.0f ;
+        }
+}
+
+template< uti::ssize_t N >
+constexpr void filter_block< N >::reset ( float const * _in_ ) noexcept
+{
+        for( uti::ssize_t i = 0; i < N; ++i )
+        {
+                float const x = _in_[ i ] ;
+
+                slew_   [ i ] = x ;
+                euro_x_ [ i ] = x ;
+                euro_dx_[ i ] = 0.0f ;
+
+                // a high-pass settles at zero, a low-pass at its input
+                hp_x1_[ i ] = x ; hp_x2_[ i ] = x ; hp_y1_[ i ] = 0.0f ; hp_y2_[ i ] = 0.0f ;
+
+                float const settled = hp_on_[ i ] ? 0.0f : x ;
+
+                lp_x1_[ i ] = settled ; lp_x2_[ i ] = settled ; lp_y1_[ i ] = settled ; lp_y2_[ i ] = settled ;
+
+                out_ [ i ] = settled ;
+                rate_[ i ] = 0.0f ;
+        }
+}
+
+template< uti::ssize_t N >
+constexpr void filter_block< N >::step ( float const * _in_, float const _dt_ ) noexcept
+{
+        for( uti::ssize_t i = 0; i < N; ++i ) scratch_[ i ] = _in_[ i ] ;
+
+        _slew    ( scratch_, _dt_ ) ;
+        _one_euro( scratch_, _dt_ ) ;
+        _highpass( scratch_, _dt_ ) ;
+        _lowpass ( scratch_, _dt_ ) ;
+
+        for( uti::ssize_t i = 0; i < N; ++i )
+        {
+                rate_[ i ] = ( scratch_[ i ] - out_[ i ] ) / _dt_ ;
+                out_ [ i ] =   scratch_[ i ] ;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< uti::ssize_t N >
+constexpr void filter_block< N >::_slew ( float * _x_, float const _dt_ ) noexcept
+{
+        for( uti::ssize_t i = 0; i < N; ++i )
+        {
+                float const step  = slew_rate_[ i ] * _dt_ ;
+                float const delta = _x_[ i ] - slew_[ i ] ;
+                float const limit = delta > step ? step : delta < -step ? -step : delta ;
+
+                slew_[ i ] = slew_[ i ] + limit ;
+                _x_  [ i ] = slew_on_[ i ] ? slew_[ i ] : _x_[ i ] ;
+        }
+}
+
+template< uti::ssize_t N >
+constexpr void filter_block< N >::_one_euro ( float * _x_, float const _dt_ ) noexcept
+{
+        for( uti::ssize_t i = 0; i < N; ++i )
+        {
+                float const dx   = ( _x_[ i ] - euro_x_[ i ] ) / _dt_ ;
+                float const edx  = euro_dx_[ i ] + _alpha( d_cutoff_[ i ], _dt_ ) * ( dx - euro_dx_[ i ] ) ;
+
+                float const cutoff = min_cutoff_[ i ] + beta_[ i ] * _abs( edx ) ;
+                float const x      = euro_x_[ i ] + _alpha( euro_on_[ i ] ? cutoff : 1.0f, _dt_ ) * ( _x_[ i ] - euro_x_[ i ] ) ;
+
+                euro_dx_[ i ] = edx ;
+                euro_x_ [ i ] = euro_on_[ i ] ? x : _x_[ i ] ;
+                _x_     [ i ] = euro_x_[ i ] ;
+        }
+}
+
+template< uti::ssize_t N >
+constexpr void filter_block< N >::_highpass ( float * _x_, float const _dt_ ) noexcept
+{
+        for( uti::ssize_t i = 0; i < N; ++i )
+        {
+                float w0 = two_pi * ( hp_on_[ i ] ? hp_cutoff_[ i ] : 1.0f ) * _dt_ ;
+                if( w0 > max_w0 ) w0 = max_w0 ;
+
+                float const cw    = std::cos( w0 ) ;
+                float const alpha = std::sin( w0 ) / ( 2.0f * biquad_q ) ;
+                float const a0    = 1.0f + alpha ;
+
+                float const b0 = ( 1.0f + cw ) / ( 2.0f * a0 ) ;
+                float const b1 = -( 1.0f + cw ) / a0 ;
+                float const a1 = -2.0f * cw / a0 ;
+                float const a2 = ( 1.0f - alpha ) / a0 ;
+
+                float const x = _x_[ i ] ;
+                float const y = b0 * x + b1 * hp_x1_[ i ] + b0 * hp_x2_[ i ] - a1 * hp_y1_[ i ] - a2 * hp_y2_[ i ] ;
+
+                hp_x2_[ i ] = hp_x1_[ i ] ; hp_x1_[ i ] = x ;
+                hp_y2_[ i ] = hp_y1_[ i ] ; hp_y1_[ i ] = y ;
+
+                _x_[ i ] = hp_on_[ i ] ? y : x ;
+        }
+}
+
+template< uti::ssize_t N >
+constexpr void filter_block< N >::_lowpass ( float * _x_, float const _dt_ ) noexcept
+{
+        for( uti::ssize_t i = 0; i < N; ++i )
+        {
+                float w0 = two_pi * ( lp_on_[ i ] ? lp_cutoff_[ i ] : 1.0f ) * _dt_ ;
+                if( w0 > max_w0 ) w0 = max_w0 ;
+
+                float const cw    = std::cos( w0 ) ;
+                float const alpha = std::sin( w0 ) / ( 2.0f * biquad_q ) ;
+                float const a0    = 1.0f + alpha ;
+
+                float const b0 = ( 1.0f - cw ) / ( 2.0f * a0 ) ;
+                float const b1 = ( 1.0f - cw ) / a0 ;
+                float const a1 = -2.0f * cw / a0 ;
+                float const a2 = ( 1.0f - alpha ) / a0 ;
+
+                float const x = _x_[ i ] ;
+                float const y = b0 * x + b1 * lp_x1_[ i ] + b0 * lp_x2_[ i ] - a1 * lp_y1_[ i ] - a2 * lp_y2_[ i ] ;
+
+                lp_x2_[ i ] = lp_x1_[ i ] ; lp_x1_[ i ] = x ;
+                lp_y2_[ i ] = lp_y1_[ i ] ; lp_y1_[ i ] = y ;
+
+                _x_[ i ] = lp_on_[ i ] ? y : x ;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr filtered_telemetry const & telemetry_filter::update ( telemetry_state const & _state_ ) noexcept
+{
+        timestamp_t const now = _state_.raw_simulation_timestamp ;
+
+        if( now == last_time_ )
+        {
+                out_.fresh   = false ;
+                out_.changed =     0 ;
+                return out_ ;
+        }
+        float in [ filtered_channel_count ] ;
+
+        in[ _idx( filtered_channel::     steering ) ] = _state_.steering ;
+        in[ _idx( filtered_channel::lateral_accel ) ] = _state_.lateral_accel ;
+        in[ _idx( filtered_channel:: deflection_l ) ] = _state_.suspension_deflection_l ;
+        in[ _idx( filtered_channel:: deflection_r ) ] = _state_.suspension_deflection_r ;
+
+        // scs timestamps are in microseconds
+        float const dt = now > last_time_ && last_time_ != static_cast< timestamp_t >( -1 )
+                       ? static_cast< float >( now - last_time_ ) * 1e-6f
+                       : 0.0f ;
+
+        if( dt <= 0.0f || dt > FFFB_FILTER_MAX_DT )
+        {
+                block_.reset( in ) ;
+                out_.dt = 0.0f ;
+        }
+        else
+        {
+                block_.step( in, dt ) ;
+                out_.dt = dt ;
+        }
+        last_time_ = now ;
+
+        float const * out  = block_.output() ;
+        float const * rate = block_.  rate() ;
+
+        float const previous [ filtered_channel_count ]
+        {
+                out_.state.steering                ,
+                out_.state.lateral_accel           ,
+                out_.state.suspension_deflection_l ,
+                out_.state.suspension_deflection_r ,
+        } ;
+        uti::u64_t moved { 0 } ;
+
+        for( uti::ssize_t i = 0; i < filtered_channel_count; ++i )
+        {
+                float const delta = out[ i ] - previous[ i ] ;
+
+                bool const moving = out_.dt == 0.0f || delta > settled_epsilon || delta < -settled_epsilon ;
+
+                moved |= moving ? field_bit( channel_fields[ i ] ) : 0 ;
+        }
+        // the step after a channel settles still changes its rate, to zero
+        out_.changed = moved | moved_last_ ;
+        moved_last_  = moved ;
+        out_.state = _state_ ;
+
+        out_.state.steering                = out[ _idx( filtered_channel::     steering ) ] ;
+        out_.state.lateral_accel           = out[ _idx( filtered_channel::lateral_accel ) ] ;
+        out_.state.suspension_deflection_l = out[ _idx( filtered_channel:: deflection_l ) ] ;
+        out_.state.suspension_deflection_r = out[ _idx( filtered_channel:: deflection_r ) ] ;
+
+        out_.    steering_rate = rate[ _idx( filtered_channel::    steering ) ] ;
+        out_.deflection_rate_l = rate[ _idx( filtered_channel::deflection_l ) ] ;
+        out_.deflection_rate_r = rate[ _idx( filtered_channel::deflection_r ) ] ;
+
+        out_.fresh = true ;
+        return out_ ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
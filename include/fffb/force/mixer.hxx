@@ -0,0 +1,345 @@
+//
+//
+//      fffb
+//      force/mixer.hxx
+//
+
+#pragma once
+
+#include <fffb/util/log.hxx>
+#include <fffb/util/types.hxx>
+#include <fffb/joy/protocol.hxx>
+#include <fffb/force/shaping.hxx>
+
+#include <cmath>
+#include <cstring>
+
+#ifndef   FFFB_MIXER_MAX_EFFECTS
+#define   FFFB_MIXER_MAX_EFFECTS 16
+#endif // FFFB_MIXER_MAX_EFFECTS
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// what a logical effect needs from the wheel, each kind competes for or sums into one hardware slot
+enum class effect_kind : uti::u8_t
+{
+        constant ,
+        spring   ,
+        damper   ,
+        periodic ,
+} ;
+
+using effect_id = uti::i32_t ;
+
+constexpr effect_id invalid_effect { -1 } ;
+
+// one sensation the simulator produces, any number of them map onto the 4 hardware slots.
+// only the fields of the effect's kind are read:
+//     constant - level is a signed torque in [-1, 1], positive pushes like the constant slot above 128
+//     spring   - spring params as they'd be downloaded, slopes add up with other springs
+//     damper   - damper params as they'd be downloaded, slopes add up with other dampers
+//     periodic - trapezoid params for when it gets the hardware slot, level and frequency for when it's summed on the host
+
+struct logical_effect
+{
+        char const *  name { nullptr } ;
+        effect_kind   kind { effect_kind::constant } ;
+        uti::u8_t priority { 0 } ;
+        float         gain { 1.0f } ;
+        bool        active { false } ;
+
+        float     level { 0.0f } ;
+        float frequency { 0.0f } ;
+
+        spring_force_params       spring {} ;
+        damper_force_params       damper {} ;
+        trapezoid_force_params trapezoid {} ;
+
+        // host oscillator state, only advanced while the effect is summed on the host
+        float phase { 0.0f } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the hardware slot parameters a compose() produced
+struct slot_composition
+{
+        constant_force_params  constant  {} ;
+        spring_force_params    spring    {} ;
+        damper_force_params    damper    {} ;
+        trapezoid_force_params trapezoid {} ;
+} ;
+
+constexpr uti::u8_t slot_bit ( force_type const _type_ ) noexcept { return uti::u8_t( 1u << static_cast< uti::u8_t >( _type_ ) ) ; }
+
+struct mixer_stats
+{
+        uti::i32_t   registered ;
+        uti::i32_t       active ;
+        uti::i32_t  host_summed ;
+        uti::u64_t      dropped ;
+        uti::u64_t    composes ;
+        uti::u64_t slot_changes ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// composes every active logical effect into one set of slot parameters per tick:
+//     constant effects and periodic effects that didn't get the trapezoid slot are summed into the constant slot,
+//     springs and dampers add their slopes into their slot, the highest priority periodic effect gets the trapezoid slot.
+// a host summed periodic effect too fast for the tick rate can't be represented and is dropped for that tick.
+// compose() reports which slots came out different from the last one, so only those are handed to the wheel
+
+class effect_mixer
+{
+public:
+        constexpr effect_mixer () noexcept = default ;
+
+        // _idle_ is what each slot gets when no effect uses it, normally the wheel's defaults
+        constexpr explicit effect_mixer ( slot_composition const & _idle_ ) noexcept : idle_( _idle_ ) {}
+
+        // registration happens once at startup, returns invalid_effect when the table is full
+        constexpr effect_id add ( char const * _name_, effect_kind _kind_, uti::u8_t _priority_, float _gain_ = 1.0f ) noexcept ;
+
+        [[ nodiscard ]] constexpr logical_effect       & effect ( effect_id const _id_ )       noexcept { return effects_[ _id_ ] ; }
+        [[ nodiscard ]] constexpr logical_effect const & effect ( effect_id const _id_ ) const noexcept { return effects_[ _id_ ] ; }
+
+        [[ nodiscard ]] constexpr uti::i32_t count () const noexcept { return count_ ; }
+
+        // the next compose() reports every slot as changed
+        constexpr void invalidate () noexcept { valid_ = false ; }
+
+        // some effect is oscillating on the host and needs a compose() every tick, not only when its inputs change
+        [[ nodiscard ]] constexpr bool host_oscillating () const noexcept { return host_summed_ > 0 ; }
+
+        // returns a mask of slot_bit() for every slot whose parameters changed
+        constexpr uti::u8_t compose ( float _period_s_ ) noexcept ;
+
+        [[ nodiscard ]] constexpr slot_composition const & composition () const noexcept { return composed_ ; }
+
+        [[ nodiscard ]] constexpr mixer_stats stats () const noexcept ;
+
+        constexpr void log_stats ( char const * _scope_ ) const noexcept ;
+private:
+        logical_effect effects_ [ FFFB_MIXER_MAX_EFFECTS ] {} ;
+        uti::i32_t     count_                               { 0 } ;
+
+        // registration order sorted by descending priority, ties keep registration order
+        effect_id order_ [ FFFB_MIXER_MAX_EFFECTS ] {} ;
+
+        slot_composition idle_     {} ;
+        slot_composition composed_ {} ;
+        bool             valid_    { false } ;
+
+        uti::i32_t active_      { 0 } ;
+        uti::i32_t host_summed_ { 0 } ;
+        uti::u64_t dropped_     { 0 } ;
+        uti::u64_t composes_    { 0 } ;
+        uti::u64_t changes_     { 0 } ;
+
+        // scales an amplitude byte's distance from center
+        static constexpr uti::u8_t _scale_amplitude ( uti::u8_t _amplitude_, float _gain_ ) noexcept
+        { return static_cast< uti::u8_t >( clampf( 128.0f + ( static_cast< float >( _amplitude_ ) - 128.0f ) * _gain_ + 0.5f, 0.0f, 255.0f ) ) ; }
+
+        static constexpr uti::u8_t _scale_slope ( uti::u8_t _slope_, float _gain_ ) noexcept
+        { return static_cast< uti::u8_t >( clampf( static_cast< float >( _slope_ ) * _gain_ + 0.5f, 0.0f, 7.0f ) ) ; }
+
+        template< typename Params >
+        static constexpr bool _differs ( Params const & _lhs_, Params const & _rhs_ ) noexcept
+        { return memcmp( &_lhs_, &_rhs_, sizeof( Params ) ) != 0 ; }
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr effect_id effect_mixer::add ( char const * _name_, effect_kind const _kind_, uti::u8_t const _priority_, float const _gain_ ) noexcept
+{
+        if( count_ >= FFFB_MIXER_MAX_EFFECTS )
+        {
+                FFFB_F_ERR_S( "effect_mixer::add", "no room for effect %s, raise FFFB_MIXER_MAX_EFFECTS", _name_ ) ;
+                return invalid_effect ;
+        }
+        effect_id const id = count_++ ;
+
+        logical_effect & fx = effects_[ id ] ;
+
+        fx = {} ;
+        fx.name     = _name_     ;
+        fx.kind     = _kind_     ;
+        fx.priority = _priority_ ;
+        fx.gain     = _gain_     ;
+
+        // insertion sort, the table is tiny and only built once
+        uti::i32_t pos = id ;
+
+        while( pos > 0 && effects_[ order_[ pos - 1 ] ].priority < _priority_ )
+        {
+                order_[ pos ] = order_[ pos - 1 ] ;
+                --pos ;
+        }
+        order_[ pos ] = id ;
+
+        valid_ = false ;
+        return id ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr uti::u8_t effect_mixer::compose ( float const _period_s_ ) noexcept
+{
+        slot_composition next { idle_ } ;
+
+        float torque          {  0.0f } ;
+        bool  constant_used   { false } ;
+        bool  spring_used     { false } ;
+        bool  damper_used     { false } ;
+        bool  trapezoid_taken { false } ;
+
+        active_      = 0 ;
+        host_summed_ = 0 ;
+
+        for( uti::i32_t i = 0; i < count_; ++i )
+        {
+                logical_effect & fx = effects_[ order_[ i ] ] ;
+
+                if( !fx.active )
+                {
+                        fx.phase = 0.0f ;
+                        continue ;
+                }
+                ++active_ ;
+
+                switch( fx.kind )
+                {
+                        case effect_kind::constant:
+                        {
+                                torque       += fx.level * fx.gain ;
+                                constant_used = true ;
+                                break ;
+                        }
+                        case effect_kind::spring:
+                        {
+                                uti::u8_t const left      = _scale_slope    ( fx.spring.slope_left , fx.gain ) ;
+                                uti::u8_t const right     = _scale_slope    ( fx.spring.slope_right, fx.gain ) ;
+                                uti::u8_t const amplitude = _scale_amplitude( fx.spring.amplitude  , fx.gain ) ;
+
+                                // the highest priority spring decides where center and its dead zone are
+                                if( !spring_used )
+                                {
+                                        next.spring             = fx.spring ;
+                                        next.spring.enabled     = true      ;
+                                        next.spring.slope_left  = left      ;
+                                        next.spring.slope_right = right     ;
+                                        next.spring.amplitude   = amplitude ;
+                                        spring_used = true ;
+                                }
+                                else
+                                {
+                                        next.spring.slope_left  = _scale_slope( next.spring.slope_left  + left , 1.0f ) ;
+                                        next.spring.slope_right = _scale_slope( next.spring.slope_right + right, 1.0f ) ;
+
+                                        if( amplitude > next.spring.amplitude ) next.spring.amplitude = amplitude ;
+                                }
+                                break ;
+                        }
+                        case effect_kind::damper:
+                        {
+                                uti::u8_t const left  = _scale_slope( fx.damper.slope_left , fx.gain ) ;
+                                uti::u8_t const right = _scale_slope( fx.damper.slope_right, fx.gain ) ;
+
+                                if( !damper_used )
+                                {
+                                        next.damper             = fx.damper ;
+                                        next.damper.enabled     = true      ;
+                                        next.damper.slope_left  = left  ;
+                                        next.damper.slope_right = right ;
+                                        damper_used = true ;
+                                }
+                                else
+                                {
+                                        next.damper.slope_left  = _scale_slope( next.damper.slope_left  + left , 1.0f ) ;
+                                        next.damper.slope_right = _scale_slope( next.damper.slope_right + right, 1.0f ) ;
+                                }
+                                break ;
+                        }
+                        case effect_kind::periodic:
+                        {
+                                if( !trapezoid_taken )
+                                {
+                                        next.trapezoid               = fx.trapezoid ;
+                                        next.trapezoid.enabled       = true         ;
+                                        next.trapezoid.amplitude_max = _scale_amplitude( fx.trapezoid.amplitude_max, fx.gain ) ;
+                                        next.trapezoid.amplitude_min = _scale_amplitude( fx.trapezoid.amplitude_min, fx.gain ) ;
+
+                                        trapezoid_taken = true ;
+                                        fx.phase        = 0.0f ;
+                                        break ;
+                                }
+                                // past nyquist it would only alias into a slower wobble
+                                if( fx.frequency * _period_s_ >= 0.5f )
+                                {
+                                        ++dropped_ ;
+                                        fx.phase = 0.0f ;
+                                        break ;
+                                }
+                                fx.phase += two_pi * fx.frequency * _period_s_ ;
+                                if( fx.phase >= two_pi ) fx.phase -= two_pi * static_cast< float >( static_cast< int >( fx.phase / two_pi ) ) ;
+
+                                torque       += fx.level * fx.gain * std::sin( fx.phase ) ;
+                                constant_used = true ;
+                                ++host_summed_ ;
+                                break ;
+                        }
+                }
+        }
+        if( constant_used )
+        {
+                next.constant.enabled   = true ;
+                next.constant.amplitude = static_cast< uti::u8_t >( clampf( 128.0f + clampf( torque, -1.0f, 1.0f ) * 127.0f + 0.5f, 1.0f, 255.0f ) ) ;
+        }
+        // whatever the effects carried, every slot goes out on its own slot
+        next.constant .slot = FFFB_FORCE_SLOT_CONSTANT  ;
+        next.spring   .slot = FFFB_FORCE_SLOT_SPRING    ;
+        next.damper   .slot = FFFB_FORCE_SLOT_DAMPER    ;
+        next.trapezoid.slot = FFFB_FORCE_SLOT_TRAPEZOID ;
+
+        uti::u8_t changed { 0 } ;
+
+        if( !valid_ || _differs( next.constant , composed_.constant  ) ) changed |= slot_bit( force_type::CONSTANT  ) ;
+        if( !valid_ || _differs( next.spring   , composed_.spring    ) ) changed |= slot_bit( force_type::SPRING    ) ;
+        if( !valid_ || _differs( next.damper   , composed_.damper    ) ) changed |= slot_bit( force_type::DAMPER    ) ;
+        if( !valid_ || _differs( next.trapezoid, composed_.trapezoid ) ) changed |= slot_bit( force_type::TRAPEZOID ) ;
+
+        composed_ = next ;
+        valid_    = true ;
+
+        ++composes_ ;
+        changes_ += ( changed & 1 ) + ( ( changed >> 1 ) & 1 ) + ( ( changed >> 2 ) & 1 ) + ( ( changed >> 3 ) & 1 ) ;
+
+        return changed ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr mixer_stats effect_mixer::stats () const noexcept
+{
+        return { count_, active_, host_summed_, dropped_, composes_, changes_ } ;
+}
+
+constexpr void effect_mixer::log_stats ( [[ maybe_unused ]] char const * _scope_ ) const noexcept
+{
+        [[ maybe_unused ]] mixer_stats const s = stats() ;
+
+        FFFB_F_INFO_S( _scope_, "mixer: %d effects, %d active, %d host summed, %llu dropped, %llu slot changes over %llu composes",
+                       s.registered, s.active, s.host_summed, s.dropped, s.slot_changes, s.composes ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
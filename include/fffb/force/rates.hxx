@@ -0,0 +1,255 @@
+//
+//
+//      fffb
+//      force/rates.hxx
+//
+
+#pragma once
+
+#include <fffb/util/log.hxx>
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+
+#ifndef   FFFB_RATE_MAX_TASKS
+#define   FFFB_RATE_MAX_TASKS 16
+#endif // FFFB_RATE_MAX_TASKS
+
+// longest schedule the planner balances over, in base ticks
+#define FFFB_RATE_PLAN_MAX_TICKS 4096
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+using rate_task_id = uti::i32_t ;
+
+constexpr rate_task_id invalid_rate_task { -1 } ;
+
+struct rate_task_stats
+{
+        char const *      name ;
+        uti::u32_t   target_hz ;
+        float      achieved_hz ;
+        float       updates_hz ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// divides one base tick rate among tasks that each declare the rate they need.
+// a task runs every n-th tick, n rounded from the base rate, and the tick it starts on is picked so that
+// as few tasks as possible land on the same tick: slow tasks spread over the schedule instead of bursting together.
+// each task accumulates the dirty bits of its inputs between its ticks and only counts as updated when some were set
+
+class rate_plan
+{
+public:
+        constexpr rate_plan () noexcept = default ;
+
+        constexpr explicit rate_plan ( uti::u32_t const _base_hz_ ) noexcept : base_hz_( _base_hz_ ) {}
+
+        // registration happens once at startup, returns invalid_rate_task when the table is full
+        constexpr rate_task_id add ( char const * _name_, uti::u32_t _rate_hz_, uti::u64_t _inputs_ ) noexcept ;
+
+        // picks every task's starting tick, call after the last add()
+        constexpr void balance () noexcept ;
+
+        // moves to the next base tick, folding this tick's dirty bits into every task
+        constexpr void advance ( uti::u64_t _dirty_ ) noexcept ;
+
+        // the task is on its tick and some input changed since it last ran, clears its pending bits.
+        // _force_ runs it regardless, for when nothing cached can be trusted
+        [[ nodiscard ]] constexpr bool run ( rate_task_id _task_, bool _force_ = false ) noexcept ;
+
+        // the task is on its tick, whether or not its inputs changed
+        [[ nodiscard ]] constexpr bool due ( rate_task_id _task_ ) const noexcept ;
+
+        [[ nodiscard ]] constexpr uti::i32_t count () const noexcept { return count_ ; }
+
+        // most tasks sharing one tick over the whole schedule
+        [[ nodiscard ]] constexpr uti::i32_t peak_load () const noexcept { return peak_load_ ; }
+
+        [[ nodiscard ]] constexpr rate_task_stats stats ( rate_task_id _task_, nanoseconds_t _now_ ) const noexcept ;
+
+        constexpr void log_stats ( char const * _scope_ ) const noexcept ;
+private:
+        struct task
+        {
+                char const *    name { nullptr } ;
+                uti::u32_t target_hz {       0 } ;
+                uti::u32_t    period {       1 } ;
+                uti::u32_t    offset {       0 } ;
+                uti::u64_t    inputs {       0 } ;
+                uti::u64_t   pending {       0 } ;
+                uti::u64_t      dues {       0 } ;
+                uti::u64_t   updates {       0 } ;
+        } ;
+        task       tasks_ [ FFFB_RATE_MAX_TASKS ] {} ;
+        uti::i32_t count_                         { 0 } ;
+
+        uti::u32_t base_hz_   { 1 } ;
+        uti::u64_t tick_      { 0 } ;
+        uti::i32_t peak_load_ { 0 } ;
+
+        nanoseconds_t started_ { 0 } ;
+
+        static constexpr uti::u32_t _gcd ( uti::u32_t _a_, uti::u32_t _b_ ) noexcept
+        { while( _b_ ) { uti::u32_t const t = _a_ % _b_ ; _a_ = _b_ ; _b_ = t ; } return _a_ ; }
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr rate_task_id rate_plan::add ( char const * _name_, uti::u32_t const _rate_hz_, uti::u64_t const _inputs_ ) noexcept
+{
+        if( count_ >= FFFB_RATE_MAX_TASKS )
+        {
+                FFFB_F_ERR_S( "rate_plan::add", "no room for task %s, raise FFFB_RATE_MAX_TASKS", _name_ ) ;
+                return invalid_rate_task ;
+        }
+        task & t = tasks_[ count_ ] ;
+
+        t = {} ;
+        t.name      = _name_   ;
+        t.target_hz = _rate_hz_ ;
+        t.inputs    = _inputs_ ;
+
+        // faster than the base rate means every tick
+        t.period = _rate_hz_ == 0 || _rate_hz_ >= base_hz_ ? 1 : ( base_hz_ + _rate_hz_ / 2 ) / _rate_hz_ ;
+
+        // the first tick after start runs everything once
+        t.pending = ~uti::u64_t( 0 ) ;
+
+        return count_++ ;
+}
+
+constexpr void rate_plan::balance () noexcept
+{
+        uti::u32_t span { 1 } ;
+
+        for( uti::i32_t i = 0; i < count_; ++i )
+        {
+                uti::u32_t const p = tasks_[ i ].period ;
+                uti::u32_t const l = span / _gcd( span, p ) * p ;
+
+                // periods with an awkward common multiple are balanced over the longest one alone
+                if( l > FFFB_RATE_PLAN_MAX_TICKS ) continue ;
+                span = l ;
+        }
+        uti::u16_t load [ FFFB_RATE_PLAN_MAX_TICKS ] {} ;
+
+        // fastest first, they leave the fewest choices
+        bool placed [ FFFB_RATE_MAX_TASKS ] {} ;
+
+        for( uti::i32_t n = 0; n < count_; ++n )
+        {
+                uti::i32_t next { -1 } ;
+
+                for( uti::i32_t i = 0; i < count_; ++i )
+                {
+                        if( !placed[ i ] && ( next < 0 || tasks_[ i ].period < tasks_[ next ].period ) ) next = i ;
+                }
+                task & t = tasks_[ next ] ;
+                placed[ next ] = true ;
+
+                uti::u32_t best_offset {          0 } ;
+                uti::u32_t best_peak   { 0xFFFFFFFF } ;
+                uti::u32_t best_sum    { 0xFFFFFFFF } ;
+
+                for( uti::u32_t offset = 0; offset < t.period; ++offset )
+                {
+                        uti::u32_t peak { 0 } ;
+                        uti::u32_t sum  { 0 } ;
+
+                        for( uti::u32_t k = offset; k < span; k += t.period )
+                        {
+                                uti::u32_t const l = load[ k % FFFB_RATE_PLAN_MAX_TICKS ] ;
+
+                                if( l > peak ) peak = l ;
+                                sum += l ;
+                        }
+                        if( peak < best_peak || ( peak == best_peak && sum < best_sum ) )
+                        {
+                                best_offset = offset ;
+                                best_peak   = peak   ;
+                                best_sum    = sum    ;
+                        }
+                }
+                t.offset = best_offset ;
+
+                for( uti::u32_t k = best_offset; k < span; k += t.period ) ++load[ k % FFFB_RATE_PLAN_MAX_TICKS ] ;
+        }
+        peak_load_ = 0 ;
+
+        for( uti::u32_t k = 0; k < span; ++k ) if( load[ k ] > peak_load_ ) peak_load_ = load[ k ] ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void rate_plan::advance ( uti::u64_t const _dirty_ ) noexcept
+{
+        if( tick_ == 0 ) started_ = monotonic_now() ;
+
+        ++tick_ ;
+
+        for( uti::i32_t i = 0; i < count_; ++i )
+        {
+                task & t = tasks_[ i ] ;
+
+                t.pending |= _dirty_ & t.inputs ;
+                t.dues    += ( tick_ % t.period ) == t.offset ;
+        }
+}
+
+constexpr bool rate_plan::due ( rate_task_id const _task_ ) const noexcept
+{
+        task const & t = tasks_[ _task_ ] ;
+
+        return ( tick_ % t.period ) == t.offset ;
+}
+
+constexpr bool rate_plan::run ( rate_task_id const _task_, bool const _force_ ) noexcept
+{
+        task & t = tasks_[ _task_ ] ;
+
+        if( !_force_ && ( !t.pending || !due( _task_ ) ) ) return false ;
+
+        t.pending = 0 ;
+        ++t.updates ;
+
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr rate_task_stats rate_plan::stats ( rate_task_id const _task_, nanoseconds_t const _now_ ) const noexcept
+{
+        task const & t = tasks_[ _task_ ] ;
+
+        float const elapsed = _now_ > started_ && tick_ > 0 ? static_cast< float >( _now_ - started_ ) / static_cast< float >( ns_per_sec ) : 0.0f ;
+
+        if( elapsed <= 0.0f ) return { t.name, t.target_hz, 0.0f, 0.0f } ;
+
+        return { t.name, t.target_hz, static_cast< float >( t.dues ) / elapsed, static_cast< float >( t.updates ) / elapsed } ;
+}
+
+constexpr void rate_plan::log_stats ( [[ maybe_unused ]] char const * _scope_ ) const noexcept
+{
+        nanoseconds_t const now = monotonic_now() ;
+
+        FFFB_F_INFO_S( _scope_, "rates: %d tasks over %u Hz, at most %d per tick", count_, base_hz_, peak_load_ ) ;
+
+        for( rate_task_id i = 0; i < count_; ++i )
+        {
+                [[ maybe_unused ]] rate_task_stats const s = stats( i, now ) ;
+
+                FFFB_F_INFO_S( _scope_, "rates: %-20s target %4u Hz achieved %7.1f Hz updated %7.1f Hz", s.name, s.target_hz, s.achieved_hz, s.updates_hz ) ;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
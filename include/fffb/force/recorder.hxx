@@ -0,0 +1,218 @@
+//
+//
+//      fffb
+//      force/recorder.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/joy/wheel.hxx>
+#include <fffb/force/simulator.hxx>
+
+#include <atomic>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef   FFFB_RECORDER_PATH
+#define   FFFB_RECORDER_PATH "/tmp/fffb.rec"
+#endif // FFFB_RECORDER_PATH
+
+#ifndef   FFFB_RECORDER_FRAMES
+#define   FFFB_RECORDER_FRAMES 65536
+#endif // FFFB_RECORDER_FRAMES
+
+#define FFFB_RECORDER_MAGIC   "FFFBREC"
+#define FFFB_RECORDER_VERSION 3
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// on-disk layout: one header followed by a ring of fixed size frames.
+// a frame's sequence is zeroed before it is rewritten and set last, so a reader can tell
+// live frames from torn or never written ones and order them without trusting the header
+
+struct alignas( FFFB_CACHE_LINE_SIZE ) recording_header
+{
+        char       magic [ 8 ] ;
+        uti::u32_t version        ;
+        uti::u32_t header_size    ;
+        uti::u32_t frame_size     ;
+        uti::u32_t telemetry_size ;
+        uti::u64_t capacity       ;
+        uti::u64_t written        ;
+} ;
+
+struct alignas( FFFB_CACHE_LINE_SIZE ) recorded_frame
+{
+        uti::u64_t                   sequence ;
+        timestamp_t  raw_simulation_timestamp ;
+        nanoseconds_t             recorded_at ;
+
+        constant_force_params   constant ;
+        spring_force_params       spring ;
+        damper_force_params       damper ;
+        trapezoid_force_params trapezoid ;
+
+        uti::u8_t report_count ;
+        report    reports [ FFFB_PROTOCOL_MAX_TICK_REPORTS ] ;
+
+        telemetry_state telemetry ;
+} ;
+
+static_assert( uti::is_trivially_copyable_v< recorded_frame >, "fffb::recorded_frame: frames are memcpy'd into the ring" ) ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// appends one frame per force feedback tick to a preallocated, memory mapped ring file.
+// record() makes no syscalls, just a handful of stores and a memcpy, but it writes to shared file pages:
+// once the kernel writes a dirty page back it write-protects it again, and the next store into it takes a minor fault
+
+class recorder
+{
+public:
+        constexpr  recorder () noexcept = default ;
+        constexpr ~recorder () noexcept { close() ; }
+
+        recorder             ( recorder const & ) = delete ;
+        recorder & operator= ( recorder const & ) = delete ;
+
+        constexpr bool  open ( char const * _path_, uti::u64_t _capacity_ ) noexcept ;
+        constexpr void close (                                            ) noexcept ;
+
+        [[ nodiscard ]] constexpr bool recording () const noexcept { return header_ != nullptr ; }
+
+        // runs on the scheduler thread right after the simulator consumed the snapshot
+        constexpr void record ( telemetry_state const & _telemetry_, wheel const & _wheel_ ) noexcept ;
+private:
+        recording_header * header_ { nullptr } ;
+        recorded_frame   * frames_ { nullptr } ;
+
+        uti::ssize_t map_size_ { 0 } ;
+        uti::u64_t   capacity_ { 0 } ;
+        uti::u64_t   written_  { 0 } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool recorder::open ( char const * _path_, uti::u64_t const _capacity_ ) noexcept
+{
+        if( recording() ) return true ;
+
+        if( _capacity_ == 0 )
+        {
+                FFFB_F_ERR_S( "recorder::open", "refusing to record into an empty ring" ) ;
+                return false ;
+        }
+        int const fd = ::open( _path_, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 ) ;
+
+        if( fd < 0 )
+        {
+                FFFB_F_ERR_S( "recorder::open", "failed opening %s, errno %d", log_copy( _path_ ), errno ) ;
+                return false ;
+        }
+        uti::ssize_t const size = sizeof( recording_header ) + _capacity_ * sizeof( recorded_frame ) ;
+
+        if( ftruncate( fd, size ) != 0 )
+        {
+                FFFB_F_ERR_S( "recorder::open", "failed sizing %s to %ld bytes, errno %d", log_copy( _path_ ), size, errno ) ;
+                ::close( fd ) ;
+                return false ;
+        }
+        void * map = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) ;
+
+        // the mapping keeps the file alive
+        ::close( fd ) ;
+
+        if( map == MAP_FAILED )
+        {
+                FFFB_F_ERR_S( "recorder::open", "failed mapping %s, errno %d", log_copy( _path_ ), errno ) ;
+                return false ;
+        }
+        // touching every page now keeps the block allocation and first-touch faults out of the tick,
+        // the minor faults after each writeback stay
+        memset( map, 0, size ) ;
+
+        header_   = static_cast< recording_header * >( map ) ;
+        frames_   = reinterpret_cast< recorded_frame * >( static_cast< char * >( map ) + sizeof( recording_header ) ) ;
+        map_size_ = size ;
+        capacity_ = _capacity_ ;
+        written_  = 0 ;
+
+        memcpy( header_->magic, FFFB_RECORDER_MAGIC, sizeof( FFFB_RECORDER_MAGIC ) ) ;
+        header_->version        = FFFB_RECORDER_VERSION ;
+        header_->header_size    = sizeof( recording_header ) ;
+        header_->frame_size     = sizeof( recorded_frame   ) ;
+        header_->telemetry_size = sizeof( telemetry_state  ) ;
+        header_->capacity       = _capacity_ ;
+        header_->written        = 0 ;
+
+        FFFB_F_INFO_S( "recorder::open", "recording %lu frames into %s", _capacity_, log_copy( _path_ ) ) ;
+        return true ;
+}
+
+constexpr void recorder::close () noexcept
+{
+        if( !recording() ) return ;
+
+        header_->written = written_ ;
+
+        // MAP_SHARED pages reach the file without this, it only makes the final state durable on return
+        msync( header_, map_size_, MS_ASYNC ) ;
+        munmap( header_, map_size_ ) ;
+
+        FFFB_F_INFO_S( "recorder::close", "recorded %lu frames", written_ ) ;
+
+        header_ = nullptr ;
+        frames_ = nullptr ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void recorder::record ( telemetry_state const & _telemetry_, wheel const & _wheel_ ) noexcept
+{
+        if( !recording() ) return ;
+
+        recorded_frame & frame = frames_[ written_ % capacity_ ] ;
+
+        frame.sequence = 0 ;
+        std::atomic_signal_fence( std::memory_order_release ) ;
+
+        frame.raw_simulation_timestamp = _telemetry_.raw_simulation_timestamp ;
+        frame.recorded_at              = monotonic_now() ;
+
+        frame.constant  = _wheel_. constant_force() ;
+        frame.spring    = _wheel_.   spring_force() ;
+        frame.damper    = _wheel_.   damper_force() ;
+        frame.trapezoid = _wheel_.trapezoid_force() ;
+
+#ifdef FFFB_RECORDER
+        report_batch const & reports = _wheel_.tapped() ;
+
+        frame.report_count = static_cast< uti::u8_t >( reports.size() ) ;
+        memcpy( frame.reports, reports.data(), reports.size() * sizeof( report ) ) ;
+#else
+        frame.report_count = 0 ;
+#endif // FFFB_RECORDER
+
+        memcpy( &frame.telemetry, &_telemetry_, sizeof( telemetry_state ) ) ;
+
+        std::atomic_signal_fence( std::memory_order_release ) ;
+        frame.sequence = ++written_ ;
+
+        header_->written = written_ ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,218 @@
+//
+//
+//      fffb
+//      force/scheduler.hxx
+//
+
+#pragma once
+
+#include <fffb/util/log.hxx>
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+
+#include <atomic>
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifndef   FFFB_FFB_RATE_HZ
+#define   FFFB_FFB_RATE_HZ 250
+#endif // FFFB_FFB_RATE_HZ
+
+#define FFFB_SCHEDULER_STATS_WINDOW_NS ( 1 * fffb::ns_per_sec )
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct scheduler_stats
+{
+        uti::u32_t      target_hz ;
+        uti::u32_t    achieved_hz ;
+        uti::u64_t          ticks ;
+        uti::u64_t deadline_misses ;
+        nanoseconds_t  max_lateness ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// runs the force feedback tick at a fixed rate on its own thread,
+// sleeping to absolute deadlines so the rate doesn't depend on the game's frame pacing
+
+class ffb_scheduler
+{
+public:
+        using tick_fn = void (*)( void * context ) ;
+
+        constexpr  ffb_scheduler () noexcept = default ;
+        constexpr ~ffb_scheduler () noexcept { stop() ; }
+
+        ffb_scheduler             ( ffb_scheduler const & ) = delete ;
+        ffb_scheduler & operator= ( ffb_scheduler const & ) = delete ;
+
+        constexpr bool start ( uti::u32_t _rate_hz_, tick_fn _tick_, void * _context_ ) noexcept ;
+        constexpr void stop  (                                                        ) noexcept ;
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_.load( std::memory_order_acquire ) ; }
+
+        [[ nodiscard ]] constexpr uti::u32_t    rate_hz () const noexcept { return rate_hz_ ; }
+        [[ nodiscard ]] constexpr nanoseconds_t  period () const noexcept { return  period_ ; }
+
+        [[ nodiscard ]] constexpr scheduler_stats stats () const noexcept ;
+
+        constexpr void log_stats ( char const * _scope_ ) const noexcept ;
+private:
+        tick_fn    tick_ { nullptr } ;
+        void * context_ { nullptr } ;
+
+        uti::u32_t    rate_hz_ { FFFB_FFB_RATE_HZ } ;
+        nanoseconds_t  period_ { ns_per_sec / FFFB_FFB_RATE_HZ } ;
+
+        pthread_t thread_ {} ;
+
+        std::atomic< bool > running_ { false } ;
+
+        std::atomic< uti::u64_t >           ticks_ { 0 } ;
+        std::atomic< uti::u64_t >          misses_ { 0 } ;
+        std::atomic< uti::u64_t >    max_lateness_ { 0 } ;
+        std::atomic< uti::u32_t >     achieved_hz_ { 0 } ;
+
+        static constexpr void * _run ( void * _self_ ) noexcept ;
+
+        constexpr void _raise_priority () const noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool ffb_scheduler::start ( uti::u32_t _rate_hz_, tick_fn _tick_, void * _context_ ) noexcept
+{
+        if( running() ) return true ;
+
+        if( _rate_hz_ == 0 || _tick_ == nullptr )
+        {
+                FFFB_F_ERR_S( "ffb_scheduler::start", "invalid rate or tick function" ) ;
+                return false ;
+        }
+        tick_    = _tick_    ;
+        context_ = _context_ ;
+        rate_hz_ = _rate_hz_ ;
+        period_  = ns_per_sec / _rate_hz_ ;
+
+        ticks_       .store( 0, std::memory_order_relaxed ) ;
+        misses_      .store( 0, std::memory_order_relaxed ) ;
+        max_lateness_.store( 0, std::memory_order_relaxed ) ;
+        achieved_hz_ .store( 0, std::memory_order_relaxed ) ;
+
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                FFFB_F_ERR_S( "ffb_scheduler::start", "failed spawning scheduler thread" ) ;
+                running_.store( false, std::memory_order_release ) ;
+                return false ;
+        }
+        FFFB_F_INFO_S( "ffb_scheduler::start", "running force feedback at %u Hz", rate_hz_ ) ;
+        return true ;
+}
+
+constexpr void ffb_scheduler::stop () noexcept
+{
+        if( !running() ) return ;
+
+        running_.store( false, std::memory_order_release ) ;
+        pthread_join( thread_, nullptr ) ;
+
+        FFFB_F_DBG_S( "ffb_scheduler::stop", "scheduler thread stopped" ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr scheduler_stats ffb_scheduler::stats () const noexcept
+{
+        return {
+                rate_hz_                                         ,
+                achieved_hz_ .load( std::memory_order_relaxed ) ,
+                ticks_       .load( std::memory_order_relaxed ) ,
+                misses_      .load( std::memory_order_relaxed ) ,
+                max_lateness_.load( std::memory_order_relaxed ) ,
+        } ;
+}
+
+constexpr void ffb_scheduler::log_stats ( [[ maybe_unused ]] char const * _scope_ ) const noexcept
+{
+        [[ maybe_unused ]] scheduler_stats const s = stats() ;
+
+        FFFB_F_INFO_S( _scope_, "scheduler: target %u Hz achieved %u Hz ticks %llu deadline misses %llu max lateness %llu us",
+                       s.target_hz, s.achieved_hz, s.ticks, s.deadline_misses, s.max_lateness / 1000 ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void * ffb_scheduler::_run ( void * _self_ ) noexcept
+{
+        ffb_scheduler * self = static_cast< ffb_scheduler * >( _self_ ) ;
+
+        self->_raise_priority() ;
+
+        nanoseconds_t deadline     = monotonic_now() ;
+        nanoseconds_t window_start = deadline ;
+        uti::u64_t    window_ticks = 0 ;
+
+        while( self->running() )
+        {
+                self->tick_( self->context_ ) ;
+
+                self->ticks_.fetch_add( 1, std::memory_order_relaxed ) ;
+                ++window_ticks ;
+
+                deadline += self->period_ ;
+
+                nanoseconds_t const now = monotonic_now() ;
+
+                if( now > deadline )
+                {
+                        nanoseconds_t const lateness = now - deadline ;
+
+                        self->misses_.fetch_add( 1, std::memory_order_relaxed ) ;
+
+                        if( lateness > self->max_lateness_.load( std::memory_order_relaxed ) )
+                        {
+                                self->max_lateness_.store( lateness, std::memory_order_relaxed ) ;
+                        }
+                        // don't try to catch up with a burst of ticks, resume the cadence from now
+                        deadline = now ;
+                }
+                else
+                {
+                        sleep_until( deadline ) ;
+                }
+                if( now - window_start >= FFFB_SCHEDULER_STATS_WINDOW_NS )
+                {
+                        self->achieved_hz_.store( static_cast< uti::u32_t >( window_ticks * ns_per_sec / ( now - window_start ) ), std::memory_order_relaxed ) ;
+
+                        window_start = now ;
+                        window_ticks =   0 ;
+                }
+        }
+        return nullptr ;
+}
+
+constexpr void ffb_scheduler::_raise_priority () const noexcept
+{
+        sched_param param {} ;
+        param.sched_priority = sched_get_priority_max( SCHED_FIFO ) / 2 ;
+
+        if( pthread_setschedparam( pthread_self(), SCHED_FIFO, &param ) != 0 )
+        {
+                FFFB_F_DBG_S( "ffb_scheduler::run", "could not raise scheduler thread priority, running with default policy" ) ;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
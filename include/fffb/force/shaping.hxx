@@ -0,0 +1,66 @@
+//
+//
+//      fffb
+//      force/shaping.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// shapes shared by every way of producing forces: the firmware effects, the streaming synth and the host controller.
+// retuning one here retunes all of them
+
+inline constexpr float two_pi { 6.28318530718f } ;
+
+// wheel is treated as stopped below this, in m/s
+inline constexpr double stopped_speed { 0.1 } ;
+
+// where the centering curve tops out, on the spring slot's amplitude scale
+inline constexpr double centering_amplitude_max { 240.0 } ;
+
+[[ nodiscard ]] constexpr float clampf ( float const _v_, float const _lo_, float const _hi_ ) noexcept
+{ return _v_ < _lo_ ? _lo_ : _v_ > _hi_ ? _hi_ : _v_ ; }
+
+// centering strength at _speed_ m/s on the spring slot's amplitude scale:
+// light but present when parking, solid in the city, strong on the highway
+[[ nodiscard ]] constexpr double centering_amplitude ( double const _speed_ ) noexcept
+{
+        double amp ;
+
+        if(      _speed_ <=  5.0 ) amp =  64.0 +   _speed_          * 12.0 ;  //  64 -> 124
+        else if( _speed_ <= 20.0 ) amp = 124.0 + ( _speed_ -  5.0 ) *  5.0 ;  // 124 -> 199
+        else                       amp = 199.0 + ( _speed_ - 20.0 ) *  2.0 ;  // 199 -> ...
+
+        return amp > centering_amplitude_max ? centering_amplitude_max : amp ;
+}
+
+// the same curve as a fraction of its maximum, nothing while stopped
+[[ nodiscard ]] constexpr float centering_stiffness ( float const _speed_ ) noexcept
+{
+        if( _speed_ < stopped_speed ) return 0.0f ;
+
+        return static_cast< float >( centering_amplitude( _speed_ ) / centering_amplitude_max ) ;
+}
+
+// engine is off or stalled below this
+inline constexpr double engine_running_rpm { 300.0 } ;
+
+// inline six, three firings per crank revolution
+inline constexpr double engine_firings_per_rev { 3.0 } ;
+
+// how often the engine fires at _rpm_, in Hz, which is the rate its vibration is felt at
+[[ nodiscard ]] constexpr double engine_firing_hz ( double const _rpm_ ) noexcept
+{ return _rpm_ / 60.0 * engine_firings_per_rev ; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -8,45 +8,24 @@
 
 #include <fffb/util/types.hxx>
 #include <fffb/joy/wheel.hxx>
+#include <fffb/force/telemetry.hxx>
+#include <fffb/force/filter.hxx>
+#include <fffb/force/mixer.hxx>
+#include <fffb/force/rates.hxx>
+#include <fffb/force/shaping.hxx>
+#include <fffb/force/scheduler.hxx>
+#ifdef FFFB_STREAMING
+#include <fffb/force/synth.hxx>
+#endif // FFFB_STREAMING
+#ifdef FFFB_HOST_CONTROL
+#include <fffb/force/controller.hxx>
+#endif // FFFB_HOST_CONTROL
 
 
 namespace fffb
 {
 
 
-////////////////////////////////////////////////////////////////////////////////
-
-struct telemetry_state
-{
-        timestamp_t                       timestamp { static_cast< timestamp_t >( -1 ) } ;
-        timestamp_t         raw_rendering_timestamp { static_cast< timestamp_t >( -1 ) } ;
-        timestamp_t        raw_simulation_timestamp { static_cast< timestamp_t >( -1 ) } ;
-        timestamp_t raw_paused_simulation_timestamp { static_cast< timestamp_t >( -1 ) } ;
-
-        bool orientation_available { false } ;
-
-        float heading { -1.0 } ;
-        float   pitch { -1.0 } ;
-        float    roll { -1.0 } ;
-
-        float steering { -1.0 } ;
-        float throttle { -1.0 } ;
-        float    brake { -1.0 } ;
-        float   clutch { -1.0 } ;
-
-        float    speed { -1.0 } ;
-        float      rpm { -1.0 } ;
-        int       gear { -1   } ;
-
-        int substance_l { -1 } ;
-        int substance_r { -1 } ;
-
-        float lateral_accel { 0.0f } ;
-
-        float suspension_deflection_l { 0.0f } ;
-        float suspension_deflection_r { 0.0f } ;
-} ;
-
 ////////////////////////////////////////////////////////////////////////////////
 
 class simulator
@@ -57,24 +36,121 @@ public:
 
         constexpr bool initialize_wheel () noexcept ;
 
+        // recomputes only the effects whose inputs are dirty in _new_state_ or still moving through the filter
         constexpr void update_forces ( telemetry_state const & _new_state_ ) noexcept ;
 
+        // the next update recomputes every effect, for when the wheel or the telemetry stream was reset underneath us
+        constexpr void invalidate () noexcept { invalid_ = true ; }
+
         constexpr wheel       & wheel_ref ()       noexcept { return wheel_ ; }
         constexpr wheel const & wheel_ref () const noexcept { return wheel_ ; }
+
+        // every sensation is a logical effect in here, the mixer decides which hardware slot carries it
+        [[ nodiscard ]] constexpr effect_mixer const & mixer () const noexcept { return mixer_ ; }
+
+        // each effect's update cadence and the rates it actually achieved
+        [[ nodiscard ]] constexpr rate_plan const & rates () const noexcept { return rates_ ; }
+
+        // the rpm leds are on their tick in the last update_forces() and rpm changed since they were last set
+        [[ nodiscard ]] constexpr bool leds_due () const noexcept { return leds_due_ ; }
+#ifdef FFFB_STREAMING
+        // per-term breakdown of the last streamed tick
+        [[ nodiscard ]] constexpr synth_terms const & stream_terms () const noexcept { return synth_.terms() ; }
+#endif // FFFB_STREAMING
+#ifdef FFFB_HOST_CONTROL
+        // breakdown of the last controller step, and whether the loop or the firmware effects drove the last tick
+        [[ nodiscard ]] constexpr controller_terms const & control_terms  () const noexcept { return controller_.terms() ; }
+        [[ nodiscard ]] constexpr bool                     control_active () const noexcept { return control_active_ ; }
+#endif // FFFB_HOST_CONTROL
 private:
         wheel wheel_ ;
+#ifdef FFFB_STREAMING
+        force_synth synth_ ;
+
+        constexpr void _update_streamed ( telemetry_state const & _new_state_ ) noexcept ;
+#endif // FFFB_STREAMING
+#ifdef FFFB_HOST_CONTROL
+        torque_controller controller_ ;
+
+        effect_id control_ { invalid_effect } ;
+
+        bool control_active_ { false } ;
+
+        // true when the loop drove this tick, false when there is no fresh wheel sample to close it on
+        constexpr bool _update_controlled ( telemetry_state const & _new_state_ ) noexcept ;
+#endif // FFFB_HOST_CONTROL
 
         constexpr void _update_autocenter ( telemetry_state const & _new_state_ ) noexcept ;
         constexpr void _update_constant   ( telemetry_state const & _new_state_ ) noexcept ;
         constexpr void _update_spring     ( telemetry_state const & _new_state_ ) noexcept ;
         constexpr void _update_damper     ( telemetry_state const & _new_state_ ) noexcept ;
-        constexpr void _update_trapezoid  ( telemetry_state const & _new_state_ ) noexcept ;
-
-        float prev_deflection_l_ { 0.0f } ;
-        float prev_deflection_r_ { 0.0f } ;
+        constexpr void _update_trapezoid  ( filtered_telemetry const & _input_ ) noexcept ;
+#ifdef FFFB_ENGINE_RUMBLE
+        constexpr void _update_engine     ( telemetry_state const & _new_state_ ) noexcept ;
+#endif // FFFB_ENGINE_RUMBLE
+
+        // composes the logical effects and hands the slots that changed to the wheel
+        constexpr void _apply_mix () noexcept ;
+
+        effect_mixer mixer_ { { wheel::default_const_f, wheel::default_spring_f, wheel::default_damper_f, wheel::default_trap_f } } ;
+
+#ifdef FFFB_STREAMING
+        rate_plan rates_ { FFFB_STREAM_RATE_HZ } ;
+#else
+        rate_plan rates_ { FFFB_FFB_RATE_HZ } ;
+#endif // FFFB_STREAMING
+
+        rate_task_id  constant_task_ { invalid_rate_task } ;
+        rate_task_id    spring_task_ { invalid_rate_task } ;
+        rate_task_id    damper_task_ { invalid_rate_task } ;
+        rate_task_id trapezoid_task_ { invalid_rate_task } ;
+#ifdef FFFB_ENGINE_RUMBLE
+        rate_task_id    engine_task_ { invalid_rate_task } ;
+#endif // FFFB_ENGINE_RUMBLE
+        rate_task_id      leds_task_ { invalid_rate_task } ;
+
+        bool leds_due_ { false } ;
+
+        effect_id       sat_ { invalid_effect } ;
+        effect_id centering_ { invalid_effect } ;
+        effect_id   damping_ { invalid_effect } ;
+        effect_id   texture_ { invalid_effect } ;
+#ifdef FFFB_ENGINE_RUMBLE
+        effect_id    engine_ { invalid_effect } ;
+#endif // FFFB_ENGINE_RUMBLE
+
+        telemetry_filter filter_ ;
+
+        bool invalid_ { true } ;
+
+        // telemetry inputs each effect reads
+        static constexpr uti::u64_t constant_inputs  { field_bit( telemetry_field::speed ) | field_bit( telemetry_field::brake ) | field_bit( telemetry_field::acceleration ) } ;
+        static constexpr uti::u64_t spring_inputs    { field_bit( telemetry_field::speed ) } ;
+        static constexpr uti::u64_t damper_inputs    { field_bit( telemetry_field::speed ) | field_bit( telemetry_field::brake ) } ;
+        static constexpr uti::u64_t trapezoid_inputs { field_bit( telemetry_field::speed )
+                                                     | field_bit( telemetry_field::substance_l  ) | field_bit( telemetry_field::substance_r  )
+                                                     | field_bit( telemetry_field::deflection_l ) | field_bit( telemetry_field::deflection_r ) } ;
+#ifdef FFFB_ENGINE_RUMBLE
+        static constexpr uti::u64_t engine_inputs    { field_bit( telemetry_field::rpm ) | field_bit( telemetry_field::throttle ) } ;
+#endif // FFFB_ENGINE_RUMBLE
+        static constexpr uti::u64_t leds_inputs      { field_bit( telemetry_field::rpm ) } ;
+
+        // how often each effect needs recomputing: lateral forces follow the road every tick,
+        // spring and damper slopes only drift with speed, the leds are read by eye
+        static constexpr uti::u32_t  constant_rate_hz { FFFB_FFB_RATE_HZ } ;
+        static constexpr uti::u32_t    spring_rate_hz {  10 } ;
+        static constexpr uti::u32_t    damper_rate_hz {  10 } ;
+        static constexpr uti::u32_t trapezoid_rate_hz {  50 } ;
+#ifdef FFFB_ENGINE_RUMBLE
+        static constexpr uti::u32_t    engine_rate_hz {  25 } ;
+#endif // FFFB_ENGINE_RUMBLE
+        static constexpr uti::u32_t      leds_rate_hz {  15 } ;
+
+        // suspension speed in m/s above which the road texture gets rougher
+        static constexpr double bump_rate_threshold { 0.3 } ;
 
         constexpr uti::u8_t _map_rmp_to_freq ( float _rpm_ ) const noexcept
-        { return ( 255 - ( _rpm_ / 3000.0f * 255.0f ) ) / 4 ; }
+        { return ( 255 - ( ( _rpm_ > 3000.0f ? 3000.0f : _rpm_ ) / 3000.0f * 255.0f ) ) / 4 ; }
 
         constexpr uti::u8_t _map_speed_to_freq ( float _speed_ ) const noexcept
         { return ( 255 - ( _speed_ / 160.0f * 255.0f ) ) / 4 ; }
@@ -83,16 +159,43 @@ private:
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
+// higher priority effects take the trapezoid slot first and decide the spring's center,
+// everything else sums into the slot of its kind
 constexpr simulator::simulator () noexcept
 {
-        if( !initialize_wheel() ) FFFB_F_ERR_S( "simulator", "failed initializing wheel!" ) ;
+        constant_task_  = rates_.add( "self-aligning torque", constant_rate_hz , constant_inputs  ) ;
+        spring_task_    = rates_.add( "centering spring"    , spring_rate_hz   , spring_inputs    ) ;
+        damper_task_    = rates_.add( "steering damper"     , damper_rate_hz   , damper_inputs    ) ;
+        trapezoid_task_ = rates_.add( "road texture"        , trapezoid_rate_hz, trapezoid_inputs ) ;
+#ifdef FFFB_ENGINE_RUMBLE
+        engine_task_    = rates_.add( "engine rumble"       , engine_rate_hz   , engine_inputs    ) ;
+#endif // FFFB_ENGINE_RUMBLE
+        leds_task_      = rates_.add( "rpm leds"            , leds_rate_hz     , leds_inputs      ) ;
+
+        rates_.balance() ;
+
+        sat_       = mixer_.add( "self-aligning torque", effect_kind::constant, 200 ) ;
+        centering_ = mixer_.add( "centering spring"    , effect_kind::spring  , 200 ) ;
+        damping_   = mixer_.add( "steering damper"     , effect_kind::damper  , 200 ) ;
+        texture_   = mixer_.add( "road texture"        , effect_kind::periodic, 150 ) ;
+#ifdef FFFB_ENGINE_RUMBLE
+        engine_    = mixer_.add( "engine rumble"       , effect_kind::periodic,  50 ) ;
+#endif // FFFB_ENGINE_RUMBLE
+#ifdef FFFB_HOST_CONTROL
+        control_   = mixer_.add( "host control"        , effect_kind::constant, 250 ) ;
+#endif // FFFB_HOST_CONTROL
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// device discovery happens here rather than at construction, the simulator is a global built at dylib load time
 constexpr bool simulator::initialize_wheel () noexcept
 {
-        if( !wheel_ ) return false ;
+        if( !wheel_.connect() )
+        {
+                FFFB_F_ERR_S( "simulator", "failed initializing wheel!" ) ;
+                return false ;
+        }
 
         wheel_.disable_autocenter() ;
         wheel_.stop_forces() ;
@@ -104,17 +207,132 @@ constexpr bool simulator::initialize_wheel () noexcept
 
 constexpr void simulator::update_forces ( telemetry_state const & _new_state_ ) noexcept
 {
-        _update_autocenter( _new_state_ ) ;
-        _update_constant  ( _new_state_ ) ;
-        _update_spring    ( _new_state_ ) ;
-        _update_damper    ( _new_state_ ) ;
-        _update_trapezoid ( _new_state_ ) ;
+        filtered_telemetry const & input = filter_.update( _new_state_ ) ;
+
+        // a reset runs every task on this tick, whatever its cadence
+        bool const force = invalid_ ;
+
+        rates_.advance( force ? ~uti::u64_t( 0 ) : _new_state_.dirty | input.changed ) ;
+
+        // a report the wheel never got is sent again on this tick, whether its inputs changed or not
+        bool const resync = wheel_.resync_pending() ;
+
+        leds_due_ = rates_.run( leds_task_, force ) || resync ;
+#ifdef FFFB_STREAMING
+        // oscillators run every tick, there is nothing to skip
+        _update_streamed( input.state ) ;
+
+        invalid_ = false ;
+#else
+#ifdef FFFB_HOST_CONTROL
+        bool const was_active = control_active_ ;
+
+        control_active_ = _update_controlled( input.state ) ;
+
+        // handing back to the firmware effects, they have to be rebuilt from the current state
+        bool const forced = force || ( was_active && !control_active_ ) ;
+#else
+        bool const forced = force ;
+#endif // FFFB_HOST_CONTROL
+        if( forced ) mixer_.invalidate() ;
+
+        invalid_ = false ;
+#ifdef FFFB_HOST_CONTROL
+        // the wheel moves between game frames, the loop is closed every tick
+        if( control_active_ )
+        {
+                if( rates_.run( trapezoid_task_, forced ) ) _update_trapezoid( input       ) ;
+#ifdef FFFB_ENGINE_RUMBLE
+                if( rates_.run(    engine_task_, forced ) ) _update_engine   ( input.state ) ;
+#endif // FFFB_ENGINE_RUMBLE
+
+                _apply_mix() ;
+                wheel_.refresh_forces() ;
+                return ;
+        }
+#endif // FFFB_HOST_CONTROL
+        // each effect runs on its own tick and only when one of its inputs changed since it last ran
+        bool const run_constant  = rates_.run(  constant_task_, forced ) ;
+        bool const run_spring    = rates_.run(    spring_task_, forced ) ;
+        bool const run_damper    = rates_.run(    damper_task_, forced ) ;
+        bool const run_trapezoid = rates_.run( trapezoid_task_, forced ) ;
+#ifdef FFFB_ENGINE_RUMBLE
+        bool const run_engine    = rates_.run(    engine_task_, forced ) ;
+
+        bool const any = run_constant || run_spring || run_damper || run_trapezoid || run_engine ;
+#else
+        bool const any = run_constant || run_spring || run_damper || run_trapezoid ;
+#endif // FFFB_ENGINE_RUMBLE
+
+        // an effect nobody touched keeps last tick's parameters, and the wheel has nothing to send.
+        // effects oscillating on the host move every tick whatever the telemetry does
+        if( !any && !resync && !mixer_.host_oscillating() ) return ;
+
+        _update_autocenter( input.state ) ;
+
+        if( run_constant  ) _update_constant ( input.state ) ;
+        if( run_spring    ) _update_spring   ( input.state ) ;
+        if( run_damper    ) _update_damper   ( input.state ) ;
+        if( run_trapezoid ) _update_trapezoid( input       ) ;
+#ifdef FFFB_ENGINE_RUMBLE
+        if( run_engine    ) _update_engine   ( input.state ) ;
+#endif // FFFB_ENGINE_RUMBLE
+
+        _apply_mix() ;
+#endif // FFFB_STREAMING
 
         wheel_.refresh_forces() ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#ifdef FFFB_STREAMING
+// every effect is summed by the synth and sent as one constant force, called once per stream tick.
+// the other slots stay off so the first refresh stops whatever calibration left playing,
+// and refresh_forces() skips the report whenever the 8 bit amplitude didn't change
+constexpr void simulator::_update_streamed ( telemetry_state const & _new_state_ ) noexcept
+{
+        wheel_.   spring_force() = wheel::default_spring_f ;
+        wheel_.   damper_force() = wheel::default_damper_f ;
+        wheel_.trapezoid_force() = wheel::default_trap_f   ;
+
+        wheel_.constant_force()           = wheel::default_const_f ;
+        wheel_.constant_force().enabled   = true ;
+        wheel_.constant_force().amplitude = synth_.step( _new_state_, ns_per_sec / FFFB_STREAM_RATE_HZ ) ;
+}
+#endif // FFFB_STREAMING
+
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef FFFB_HOST_CONTROL
+// centering and damping come from the host loop as a constant effect, the spring and damper effects stay off.
+// self-aligning torque is part of the loop's target, so its own effect is off as well
+constexpr bool simulator::_update_controlled ( telemetry_state const & _new_state_ ) noexcept
+{
+        wheel_input const measured = wheel_.input() ;
+
+        logical_effect & control = mixer_.effect( control_ ) ;
+
+        if( !torque_controller::usable( measured, monotonic_now() ) )
+        {
+                controller_.reset() ;
+                control.active = false ;
+                return false ;
+        }
+        mixer_.effect(       sat_ ).active = false ;
+        mixer_.effect( centering_ ).active = false ;
+        mixer_.effect(   damping_ ).active = false ;
+
+        // back from the slot byte, so the mix reproduces exactly what the controller asked for
+        control.active = true ;
+        control.level  = ( static_cast< float >( controller_.step( _new_state_, measured ) ) - 128.0f ) / 127.0f ;
+
+        return true ;
+}
+#endif // FFFB_HOST_CONTROL
+
+////////////////////////////////////////////////////////////////////////////////
+
 constexpr void simulator::_update_autocenter ( [[ maybe_unused ]] telemetry_state const & _new_state_ ) noexcept
 {}
 
@@ -144,17 +362,11 @@ constexpr void simulator::_update_constant ( telemetry_state const & _new_state_
         if( amplitude <  8.0 ) amplitude =  8.0 ;
         if( amplitude > 248.0 ) amplitude = 248.0 ;
 
-        wheel_.constant_force() = wheel::default_const_f ;
+        logical_effect & sat = mixer_.effect( sat_ ) ;
 
-        if( speed < 0.1 )
-        {
-                wheel_.constant_force().enabled = false ;
-        }
-        else
-        {
-                wheel_.constant_force().enabled   = true ;
-                wheel_.constant_force().amplitude = static_cast< uti::u8_t >( amplitude ) ;
-        }
+        // no force when stopped, otherwise the same 8 bit amplitude the slot would get, as a signed level
+        sat.active = speed >= stopped_speed ;
+        sat.level  = ( static_cast< float >( static_cast< uti::u8_t >( amplitude ) ) - 128.0f ) / 127.0f ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -163,19 +375,18 @@ constexpr void simulator::_update_spring ( telemetry_state const & _new_state_ )
 {
         double speed = _new_state_.speed < 0.0 ? -_new_state_.speed : _new_state_.speed ;
 
-        wheel_.spring_force() = wheel::default_spring_f ;
+        logical_effect & centering = mixer_.effect( centering_ ) ;
 
-        if( speed < 0.10 )
-        {
-                wheel_.spring_force().enabled = false ;
-        }
-        else
+        centering.spring = wheel::default_spring_f ;
+        centering.active = speed >= stopped_speed ;
+
+        if( centering.active )
         {
-                wheel_.spring_force().enabled = true ;
+                centering.spring.enabled = true ;
 
                 // small dead zone at center
-                wheel_.spring_force().dead_start = 126 ;
-                wheel_.spring_force().dead_end   = 130 ;
+                centering.spring.dead_start = 126 ;
+                centering.spring.dead_end   = 130 ;
 
                 // slope: max is 7 (3-bit). aggressive ramp with speed
                 uti::u8_t slope ;
@@ -195,28 +406,11 @@ constexpr void simulator::_update_spring ( telemetry_state const & _new_state_ )
                         if( s > 7.0 ) s = 7.0 ;
                         slope = static_cast< uti::u8_t >( s ) ;
                 }
-                wheel_.spring_force().slope_left  = slope ;
-                wheel_.spring_force().slope_right = slope ;
+                centering.spring.slope_left  = slope ;
+                centering.spring.slope_right = slope ;
 
                 // amplitude: strong centering force that ramps up with speed
-                // parking (< 5 m/s): light but present
-                // city (5-20 m/s): solid centering
-                // highway (20+ m/s): very strong centering
-                double amp ;
-                if( speed <= 5.0 )
-                {
-                        amp = 64.0 + speed * 12.0 ;   // 64 -> 124
-                }
-                else if( speed <= 20.0 )
-                {
-                        amp = 124.0 + ( speed - 5.0 ) * 5.0 ;  // 124 -> 199
-                }
-                else
-                {
-                        amp = 199.0 + ( speed - 20.0 ) * 2.0 ;  // 199 -> ...
-                }
-                if( amp > 240.0 ) amp = 240.0 ;
-                wheel_.spring_force().amplitude = static_cast< uti::u8_t >( amp ) ;
+                centering.spring.amplitude = static_cast< uti::u8_t >( centering_amplitude( speed ) ) ;
         }
 }
 
@@ -227,8 +421,11 @@ constexpr void simulator::_update_damper ( telemetry_state const & _new_state_ )
         double speed = _new_state_.speed < 0.0 ? -_new_state_.speed : _new_state_.speed ;
         double brake = static_cast< double >( _new_state_.brake ) ;
 
-        wheel_.damper_force() = wheel::default_damper_f ;
-        wheel_.damper_force().enabled = true ;
+        logical_effect & damping = mixer_.effect( damping_ ) ;
+
+        damping.damper         = wheel::default_damper_f ;
+        damping.damper.enabled = true ;
+        damping.active         = true ;
 
         // base slope: ramps faster to give noticeable resistance
         double base_slope = speed / 10.0 * 5.0 ;
@@ -241,53 +438,53 @@ constexpr void simulator::_update_damper ( telemetry_state const & _new_state_ )
         int slope = static_cast< int >( base_slope ) + brake_bonus ;
         if( slope > 7 ) slope = 7 ;
 
-        wheel_.damper_force().slope_left  = static_cast< uti::u8_t >( slope ) ;
-        wheel_.damper_force().slope_right = static_cast< uti::u8_t >( slope ) ;
+        damping.damper.slope_left  = static_cast< uti::u8_t >( slope ) ;
+        damping.damper.slope_right = static_cast< uti::u8_t >( slope ) ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr void simulator::_update_trapezoid ( telemetry_state const & _new_state_ ) noexcept
+constexpr void simulator::_update_trapezoid ( filtered_telemetry const & _input_ ) noexcept
 {
+        telemetry_state const & _new_state_ = _input_.state ;
+
         double speed = _new_state_.speed < 0.0 ? -_new_state_.speed : _new_state_.speed ;
         int sub_l = _new_state_.substance_l ;
         int sub_r = _new_state_.substance_r ;
 
-        wheel_.trapezoid_force() = wheel::default_trap_f ;
+        logical_effect & texture = mixer_.effect( texture_ ) ;
+
+        texture.trapezoid = wheel::default_trap_f ;
 
         bool offroad = ( sub_l != 0 ) || ( sub_r != 0 ) ;
 
         if( !offroad || speed < 0.5 )
         {
-                wheel_.trapezoid_force().enabled = false ;
-                prev_deflection_l_ = _new_state_.suspension_deflection_l ;
-                prev_deflection_r_ = _new_state_.suspension_deflection_r ;
+                texture.active = false ;
                 return ;
         }
 
-        wheel_.trapezoid_force().enabled = true ;
+        texture.active            = true ;
+        texture.trapezoid.enabled = true ;
 
-        // suspension deflection delta for bump detection
-        double delta_l = _new_state_.suspension_deflection_l - prev_deflection_l_ ;
-        double delta_r = _new_state_.suspension_deflection_r - prev_deflection_r_ ;
-        if( delta_l < 0.0 ) delta_l = -delta_l ;
-        if( delta_r < 0.0 ) delta_r = -delta_r ;
-        double defl_delta = delta_l > delta_r ? delta_l : delta_r ;
-
-        prev_deflection_l_ = _new_state_.suspension_deflection_l ;
-        prev_deflection_r_ = _new_state_.suspension_deflection_r ;
+        // suspension speed over simulation time for bump detection
+        double rate_l = _input_.deflection_rate_l ;
+        double rate_r = _input_.deflection_rate_r ;
+        if( rate_l < 0.0 ) rate_l = -rate_l ;
+        if( rate_r < 0.0 ) rate_r = -rate_r ;
+        double defl_rate = rate_l > rate_r ? rate_l : rate_r ;
 
         // amplitude range: mild vibration around center (128)
         // expand range when suspension is bouncing
-        double bump_extra = defl_delta > 0.005 ? 4.0 : 0.0 ;
+        double bump_extra = defl_rate > bump_rate_threshold ? 4.0 : 0.0 ;
 
         double amp_max = 116.0 - bump_extra ;
         double amp_min = 140.0 + bump_extra ;
         if( amp_max < 96.0  ) amp_max = 96.0  ;
         if( amp_min > 160.0 ) amp_min = 160.0 ;
 
-        wheel_.trapezoid_force().amplitude_max = static_cast< uti::u8_t >( amp_max ) ;
-        wheel_.trapezoid_force().amplitude_min = static_cast< uti::u8_t >( amp_min ) ;
+        texture.trapezoid.amplitude_max = static_cast< uti::u8_t >( amp_max ) ;
+        texture.trapezoid.amplitude_min = static_cast< uti::u8_t >( amp_min ) ;
 
         // slope and timing scale with speed for more pronounced vibration at speed
         double speed_scale = speed / 30.0 ;
@@ -296,15 +493,75 @@ constexpr void simulator::_update_trapezoid ( telemetry_state const & _new_state
         uti::u8_t slope = static_cast< uti::u8_t >( 2.0 + speed_scale * 6.0 ) ;
         if( slope > 0x0F ) slope = 0x0F ;
 
-        wheel_.trapezoid_force().slope_step_x = slope ;
-        wheel_.trapezoid_force().slope_step_y = slope ;
+        texture.trapezoid.slope_step_x = slope ;
+        texture.trapezoid.slope_step_y = slope ;
 
         // shorter periods at speed for faster oscillation
         uti::u8_t t_val = static_cast< uti::u8_t >( 48.0 - speed_scale * 32.0 ) ;
         if( t_val < 8 ) t_val = 8 ;
 
-        wheel_.trapezoid_force().t_at_max = t_val ;
-        wheel_.trapezoid_force().t_at_min = t_val ;
+        texture.trapezoid.t_at_max = t_val ;
+        texture.trapezoid.t_at_min = t_val ;
+
+        // for when a higher priority effect holds the trapezoid slot and this one is summed on the host
+        texture.frequency = static_cast< float >( 8.0 + speed_scale * 32.0 ) ;
+        texture.level     = static_cast< float >( ( amp_min - amp_max ) / 2.0 / 127.0 ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef FFFB_ENGINE_RUMBLE
+constexpr void simulator::_update_engine ( telemetry_state const & _new_state_ ) noexcept
+{
+        double rpm      = static_cast< double >( _new_state_.rpm      ) ;
+        double throttle = static_cast< double >( _new_state_.throttle ) ;
+
+        logical_effect & engine = mixer_.effect( engine_ ) ;
+
+        engine.trapezoid = wheel::default_trap_f ;
+
+        if( rpm < engine_running_rpm )
+        {
+                engine.active = false ;
+                return ;
+        }
+        if( throttle < 0.0 ) throttle = 0.0 ;
+        if( throttle > 1.0 ) throttle = 1.0 ;
+
+        engine.active            = true ;
+        engine.trapezoid.enabled = true ;
+
+        // a light buzz at idle that picks up with the gas pedal
+        double swing = 2.0 + throttle * 4.0 ;
+
+        engine.trapezoid.amplitude_max = static_cast< uti::u8_t >( 128.0 - swing ) ;
+        engine.trapezoid.amplitude_min = static_cast< uti::u8_t >( 128.0 + swing ) ;
+
+        uti::u8_t t_val = _map_rmp_to_freq( static_cast< float >( rpm ) ) ;
+        if( t_val < 1 ) t_val = 1 ;
+
+        engine.trapezoid.t_at_max     = t_val ;
+        engine.trapezoid.t_at_min     = t_val ;
+        engine.trapezoid.slope_step_x = 0x0F ;
+        engine.trapezoid.slope_step_y = 0x0F ;
+
+        engine.frequency = static_cast< float >( engine_firing_hz( rpm ) ) ;
+        engine.level     = static_cast< float >( swing / 127.0 ) ;
+}
+#endif // FFFB_ENGINE_RUMBLE
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void simulator::_apply_mix () noexcept
+{
+        uti::u8_t const changed = mixer_.compose( 1.0f / static_cast< float >( FFFB_FFB_RATE_HZ ) ) ;
+
+        slot_composition const & mix = mixer_.composition() ;
+
+        if( changed & slot_bit( force_type::CONSTANT  ) ) wheel_. constant_force() = mix.constant  ;
+        if( changed & slot_bit( force_type::SPRING    ) ) wheel_.   spring_force() = mix.spring    ;
+        if( changed & slot_bit( force_type::DAMPER    ) ) wheel_.   damper_force() = mix.damper    ;
+        if( changed & slot_bit( force_type::TRAPEZOID ) ) wheel_.trapezoid_force() = mix.trapezoid ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,253 @@
+//
+//
+//      fffb
+//      force/synth.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/force/telemetry.hxx>
+#include <fffb/force/shaping.hxx>
+
+#include <cmath>
+
+#ifndef   FFFB_STREAM_RATE_HZ
+#define   FFFB_STREAM_RATE_HZ 500
+#endif // FFFB_STREAM_RATE_HZ
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// per-term contributions of the last step, signed and normalized to [-1, 1] of full wheel torque.
+// positive pushes the same way the constant slot does above 128
+struct synth_terms
+{
+        float     sat { 0.0f } ;
+        float  center { 0.0f } ;
+        float  damper { 0.0f } ;
+        float texture { 0.0f } ;
+        float  engine { 0.0f } ;
+        float  impact { 0.0f } ;
+        float   total { 0.0f } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// sums every effect into a single torque on the host, for streaming through the constant slot.
+// step() is called once per stream tick, oscillators advance by the tick period rather than by game frames
+// so texture and engine vibration keep their frequency whatever the game's frame rate is.
+// steering velocity and bump detection are taken over simulation time, held between game frames
+
+class force_synth
+{
+public:
+        constexpr force_synth () noexcept = default ;
+
+        constexpr void reset () noexcept { *this = force_synth{} ; }
+
+        // returns the constant slot amplitude for this tick
+        [[ nodiscard ]] constexpr uti::u8_t step ( telemetry_state const & _state_, nanoseconds_t _period_ ) noexcept ;
+
+        [[ nodiscard ]] constexpr synth_terms const & terms () const noexcept { return terms_ ; }
+private:
+        synth_terms terms_ {} ;
+
+        timestamp_t last_sim_time_ { static_cast< timestamp_t >( -1 ) } ;
+
+        float prev_steering_     { 0.0f } ;
+        float prev_deflection_l_ { 0.0f } ;
+        float prev_deflection_r_ { 0.0f } ;
+
+        // set for the first step after a new game frame arrived
+        bool fresh_ { false } ;
+
+        float steering_velocity_     { 0.0f } ;
+        float deflection_velocity_l_ { 0.0f } ;
+        float deflection_velocity_r_ { 0.0f } ;
+
+        float texture_phase_ { 0.0f } ;
+        float  engine_phase_ { 0.0f } ;
+
+        float impact_ { 0.0f } ;
+
+        // full scale torque fractions of each term
+        static constexpr float sat_gain      { 32.0f / 127.0f } ;
+        static constexpr float center_max    { 0.45f } ;
+        static constexpr float damper_max    { 0.08f } ;
+        static constexpr float texture_max   { 0.06f } ;
+        static constexpr float engine_max    { 0.015f } ;
+        static constexpr float impact_gain   { 0.6f  } ;
+
+        // suspension deflection speed in m/s above which a hit counts as an impact
+        static constexpr float impact_threshold { 0.25f } ;
+        static constexpr float impact_decay_s   { 0.04f } ;
+
+        constexpr void _track_inputs ( telemetry_state const & _state_ ) noexcept ;
+
+        constexpr float _sat     ( telemetry_state const & _state_, float _speed_                   ) const noexcept ;
+        constexpr float _center  ( telemetry_state const & _state_, float _speed_                   ) const noexcept ;
+        constexpr float _damper  ( telemetry_state const & _state_, float _speed_                   ) const noexcept ;
+        constexpr float _texture ( telemetry_state const & _state_, float _speed_, float _period_s_ )       noexcept ;
+        constexpr float _engine  ( telemetry_state const & _state_,                float _period_s_ )       noexcept ;
+        constexpr float _impact  (                                  float _speed_, float _period_s_ )       noexcept ;
+
+        static constexpr float _wrap_phase ( float _phase_ ) noexcept
+        { return _phase_ >= two_pi ? _phase_ - two_pi * static_cast< float >( static_cast< int >( _phase_ / two_pi ) ) : _phase_ ; }
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr uti::u8_t force_synth::step ( telemetry_state const & _state_, nanoseconds_t const _period_ ) noexcept
+{
+        float const period_s = static_cast< float >( _period_ ) / static_cast< float >( ns_per_sec ) ;
+        float const speed    = _state_.speed < 0.0f ? -_state_.speed : _state_.speed ;
+
+        _track_inputs( _state_ ) ;
+
+        terms_.sat     = _sat    ( _state_, speed           ) ;
+        terms_.center  = _center ( _state_, speed           ) ;
+        terms_.damper  = _damper ( _state_, speed           ) ;
+        terms_.texture = _texture( _state_, speed, period_s ) ;
+        terms_.engine  = _engine ( _state_,        period_s ) ;
+        terms_.impact  = _impact (          speed, period_s ) ;
+
+        terms_.total = clampf( terms_.sat + terms_.center + terms_.damper + terms_.texture + terms_.engine + terms_.impact, -1.0f, 1.0f ) ;
+
+        return static_cast< uti::u8_t >( clampf( 128.0f + terms_.total * 127.0f + 0.5f, 1.0f, 255.0f ) ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void force_synth::_track_inputs ( telemetry_state const & _state_ ) noexcept
+{
+        fresh_ = _state_.raw_simulation_timestamp != last_sim_time_ ;
+
+        if( !fresh_ ) return ;
+
+        if( last_sim_time_ != static_cast< timestamp_t >( -1 ) && _state_.raw_simulation_timestamp > last_sim_time_ )
+        {
+                // scs timestamps are in microseconds
+                float const dt = static_cast< float >( _state_.raw_simulation_timestamp - last_sim_time_ ) * 1e-6f ;
+
+                steering_velocity_     = ( _state_.steering                - prev_steering_     ) / dt ;
+                deflection_velocity_l_ = ( _state_.suspension_deflection_l - prev_deflection_l_ ) / dt ;
+                deflection_velocity_r_ = ( _state_.suspension_deflection_r - prev_deflection_r_ ) / dt ;
+        }
+        else
+        {
+                // first frame or timer restart, nothing to differentiate against
+                steering_velocity_     = 0.0f ;
+                deflection_velocity_l_ = 0.0f ;
+                deflection_velocity_r_ = 0.0f ;
+        }
+        prev_steering_     = _state_.steering ;
+        prev_deflection_l_ = _state_.suspension_deflection_l ;
+        prev_deflection_r_ = _state_.suspension_deflection_r ;
+        last_sim_time_     = _state_.raw_simulation_timestamp ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr float force_synth::_sat ( telemetry_state const & _state_, float const _speed_ ) const noexcept
+{
+        // ramp up over 0-5 m/s, reduced on heavy braking for grip loss
+        float const speed_factor = clampf( _speed_ / 5.0f, 0.0f, 1.0f ) ;
+        float const brake_factor = _state_.brake > 0.7f ? 0.6f : 1.0f ;
+
+        return clampf( _state_.lateral_accel * sat_gain * speed_factor * brake_factor, -0.94f, 0.94f ) ;
+}
+
+constexpr float force_synth::_center ( telemetry_state const & _state_, float const _speed_ ) const noexcept
+{
+        float const stiffness = centering_stiffness( _speed_ ) ;
+
+        // small dead zone at center so we don't fight the player
+        float const offset = _state_.steering < 0.0f ? -_state_.steering : _state_.steering ;
+        float const past   = offset > 0.016f ? offset - 0.016f : 0.0f ;
+
+        return ( _state_.steering < 0.0f ? past : -past ) * center_max * stiffness ;
+}
+
+constexpr float force_synth::_damper ( telemetry_state const & _state_, float const _speed_ ) const noexcept
+{
+        // resistance grows with speed, braking shifts weight onto the front axle
+        float coefficient = clampf( _speed_ / 10.0f * 5.0f, 2.0f, 6.0f ) / 7.0f ;
+
+        if( _state_.brake > 0.3f ) coefficient += 1.0f / 7.0f ;
+
+        return clampf( -steering_velocity_ * damper_max * coefficient, -0.2f, 0.2f ) ;
+}
+
+constexpr float force_synth::_texture ( telemetry_state const & _state_, float const _speed_, float const _period_s_ ) noexcept
+{
+        bool const offroad = _state_.substance_l != 0 || _state_.substance_r != 0 ;
+
+        if( !offroad || _speed_ < 0.5f )
+        {
+                texture_phase_ = 0.0f ;
+                return 0.0f ;
+        }
+        float const speed_scale = clampf( _speed_ / 30.0f, 0.0f, 1.0f ) ;
+        float const frequency   = 8.0f + speed_scale * 32.0f ;
+
+        float const dl = deflection_velocity_l_ < 0.0f ? -deflection_velocity_l_ : deflection_velocity_l_ ;
+        float const dr = deflection_velocity_r_ < 0.0f ? -deflection_velocity_r_ : deflection_velocity_r_ ;
+
+        // rougher while the suspension is working
+        float const bumpy     = ( dl > dr ? dl : dr ) > 0.05f ? 1.5f : 1.0f ;
+        float const amplitude = texture_max * ( 0.5f + 0.5f * speed_scale ) * bumpy ;
+
+        texture_phase_ = _wrap_phase( texture_phase_ + two_pi * frequency * _period_s_ ) ;
+
+        return amplitude * std::sin( texture_phase_ ) ;
+}
+
+constexpr float force_synth::_engine ( telemetry_state const & _state_, float const _period_s_ ) noexcept
+{
+        float const frequency = static_cast< float >( engine_firing_hz( _state_.rpm ) ) ;
+
+        // off, or too fast to be represented at this stream rate
+        if( _state_.rpm < engine_running_rpm || frequency * _period_s_ >= 0.5f )
+        {
+                engine_phase_ = 0.0f ;
+                return 0.0f ;
+        }
+        float const throttle = clampf( _state_.throttle, 0.0f, 1.0f ) ;
+
+        engine_phase_ = _wrap_phase( engine_phase_ + two_pi * frequency * _period_s_ ) ;
+
+        return engine_max * ( 0.4f + 0.6f * throttle ) * std::sin( engine_phase_ ) ;
+}
+
+constexpr float force_synth::_impact ( float const _speed_, float const _period_s_ ) noexcept
+{
+        impact_ *= std::exp( -_period_s_ / impact_decay_s ) ;
+
+        if( !fresh_ || _speed_ < 0.5f ) return impact_ ;
+
+        float const dl = deflection_velocity_l_ < 0.0f ? -deflection_velocity_l_ : deflection_velocity_l_ ;
+        float const dr = deflection_velocity_r_ < 0.0f ? -deflection_velocity_r_ : deflection_velocity_r_ ;
+
+        float const hit = dl > dr ? dl : dr ;
+
+        if( hit < impact_threshold ) return impact_ ;
+
+        // a hit on the left wheel yanks the rim to the left
+        float const kick = clampf( ( hit - impact_threshold ) * impact_gain, 0.0f, 0.5f ) * ( dl > dr ? 1.0f : -1.0f ) ;
+
+        if( ( kick < 0.0f ? -kick : kick ) > ( impact_ < 0.0f ? -impact_ : impact_ ) ) impact_ = kick ;
+
+        return impact_ ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
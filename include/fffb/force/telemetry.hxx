@@ -0,0 +1,86 @@
+//
+//
+//      fffb
+//      force/telemetry.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// one bit per telemetry input in telemetry_state::dirty.
+// an input can span several fields, the acceleration vector or the orientation angles for instance
+
+enum class telemetry_field : uti::u8_t
+{
+        orientation  ,
+        speed        ,
+        rpm          ,
+        gear         ,
+        steering     ,
+        throttle     ,
+        brake        ,
+        clutch       ,
+        substance_l  ,
+        substance_r  ,
+        acceleration ,
+        deflection_l ,
+        deflection_r ,
+        count        ,
+} ;
+
+inline constexpr uti::ssize_t telemetry_field_count { static_cast< uti::ssize_t >( telemetry_field::count ) } ;
+
+static_assert( telemetry_field_count <= 64, "fffb::telemetry_field: the dirty mask is 64 bits wide" ) ;
+
+constexpr uti::u64_t field_bit ( telemetry_field const _field_ ) noexcept { return uti::u64_t( 1 ) << static_cast< uti::u8_t >( _field_ ) ; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+// published as a whole once per frame, aligned so snapshots don't share cache lines with neighbouring globals
+struct alignas( FFFB_CACHE_LINE_SIZE ) telemetry_state
+{
+        timestamp_t                       timestamp { static_cast< timestamp_t >( -1 ) } ;
+        timestamp_t         raw_rendering_timestamp { static_cast< timestamp_t >( -1 ) } ;
+        timestamp_t        raw_simulation_timestamp { static_cast< timestamp_t >( -1 ) } ;
+        timestamp_t raw_paused_simulation_timestamp { static_cast< timestamp_t >( -1 ) } ;
+
+        // inputs the game wrote during this frame
+        uti::u64_t dirty { 0 } ;
+
+        float heading { -1.0 } ;
+        float   pitch { -1.0 } ;
+        float    roll { -1.0 } ;
+
+        float steering { -1.0 } ;
+        float throttle { -1.0 } ;
+        float    brake { -1.0 } ;
+        float   clutch { -1.0 } ;
+
+        float    speed { -1.0 } ;
+        float      rpm { -1.0 } ;
+        int       gear { -1   } ;
+
+        int substance_l { -1 } ;
+        int substance_r { -1 } ;
+
+        // truck local space, x to the right, y up, z backwards
+        float      lateral_accel { 0.0f } ;
+        float     vertical_accel { 0.0f } ;
+        float longitudinal_accel { 0.0f } ;
+
+        float suspension_deflection_l { 0.0f } ;
+        float suspension_deflection_r { 0.0f } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,405 @@
+//
+//
+//      fffb
+//      hid/hidraw/device.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/hid/report.hxx>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define FFFB_HIDRAW_SYSFS_PATH "/sys/class/hidraw"
+#define FFFB_HIDRAW_DEV_PATH   "/dev"
+
+#define FFFB_HIDRAW_PATH_LEN        128
+#define FFFB_HIDRAW_UEVENT_LEN     1024
+#define FFFB_HIDRAW_DESCRIPTOR_LEN 4096
+
+
+namespace fffb
+{
+
+
+namespace _detail
+{
+
+
+[[ nodiscard ]] constexpr uti::ssize_t read_sysfs_file ( char const * path, void * buffer, uti::ssize_t capacity ) noexcept ;
+
+[[ nodiscard ]] constexpr bool parse_hid_id        ( char const * uevent, uti::u32_t & vendor_id, uti::u32_t & product_id ) noexcept ;
+[[ nodiscard ]] constexpr bool parse_primary_usage ( uti::u8_t const * descriptor, uti::ssize_t len, uti::u32_t & usage_page, uti::u32_t & usage ) noexcept ;
+
+
+} // namespace _detail
+
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+// a /dev/hidraw* node, the fd stays open for the lifetime of the session
+// so every report is a single write() with no per-report lookup
+
+class hid_device
+{
+public:
+        constexpr hid_device () noexcept = default ;
+
+        constexpr hid_device ( char const * node, device_id_t vendor_id, device_id_t product_id, device_id_t usage_page, device_id_t usage ) noexcept
+                :  vendor_id_( vendor_id )
+                , product_id_( product_id )
+                ,  device_id_( make_device_id( product_id, vendor_id ) )
+                , usage_page_( usage_page )
+                , usage_     ( usage )
+        {
+                snprintf( node_, sizeof( node_ ), "%s", node ) ;
+        }
+
+        hid_device             ( hid_device const & ) = delete ;
+        hid_device & operator= ( hid_device const & ) = delete ;
+
+        constexpr hid_device ( hid_device && other ) noexcept { _take( other ) ; }
+
+        constexpr hid_device & operator= ( hid_device && other ) noexcept
+        {
+                if( this != &other )
+                {
+                        close() ;
+                        _take( other ) ;
+                }
+                return *this ;
+        }
+
+        constexpr ~hid_device () noexcept { close() ; }
+
+        [[ nodiscard ]] constexpr operator bool () const noexcept { return node_[ 0 ] != '\0' ; }
+
+        [[ nodiscard ]] constexpr bool  open () noexcept ;
+                        constexpr bool close () noexcept ;
+
+        [[ nodiscard ]] constexpr   bool write ( report const & report ) const noexcept ;
+        [[ nodiscard ]] constexpr report  read (                       ) const noexcept ;
+
+        [[ nodiscard ]] constexpr char const * node () const noexcept { return node_ ; }
+
+        [[ nodiscard ]] constexpr device_id_t  vendor_id () const noexcept { return  vendor_id_ ; }
+        [[ nodiscard ]] constexpr device_id_t product_id () const noexcept { return product_id_ ; }
+        [[ nodiscard ]] constexpr device_id_t  device_id () const noexcept { return  device_id_ ; }
+
+        [[ nodiscard ]] constexpr device_id_t usage_page () const noexcept { return usage_page_ ; }
+        [[ nodiscard ]] constexpr device_id_t usage      () const noexcept { return usage_      ; }
+
+        constexpr bool operator== ( hid_device const & other ) const noexcept
+        {
+                return strcmp( node_, other.node_ ) == 0
+                    && usage_page_ == other.usage_page_
+                    && usage_      == other.usage_    ;
+        }
+        constexpr bool operator!= ( hid_device const & other ) const noexcept { return !operator==( other ) ; }
+private:
+        char node_ [ FFFB_HIDRAW_PATH_LEN ] {} ;
+        int  fd_                            { -1 } ;
+
+        device_id_t  vendor_id_ { 0 } ;
+        device_id_t product_id_ { 0 } ;
+        device_id_t  device_id_ { 0 } ;
+        device_id_t usage_page_ { 0 } ;
+        device_id_t usage_      { 0 } ;
+
+        constexpr void _take ( hid_device & other ) noexcept
+        {
+                memcpy( node_, other.node_, sizeof( node_ ) ) ;
+
+                fd_         = other.fd_         ;
+                 vendor_id_ = other. vendor_id_ ;
+                product_id_ = other.product_id_ ;
+                 device_id_ = other. device_id_ ;
+                usage_page_ = other.usage_page_ ;
+                usage_      = other.usage_      ;
+
+                other.fd_        = -1   ;
+                other.node_[ 0 ] = '\0' ;
+        }
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool hid_device::open () noexcept
+{
+        if( fd_ >= 0 ) return true ;
+
+        fd_ = ::open( node_, O_RDWR | O_CLOEXEC ) ;
+
+        if( fd_ < 0 )
+        {
+                FFFB_F_ERR_S( "open_device", "failed opening hidraw node, errno %d", errno ) ;
+                return false ;
+        }
+        return true ;
+}
+
+constexpr bool hid_device::close () noexcept
+{
+        if( fd_ < 0 ) return true ;
+
+        int const result = ::close( fd_ ) ;
+        fd_ = -1 ;
+
+        if( result != 0 )
+        {
+                FFFB_F_ERR_S( "close_device", "failed closing hidraw node, errno %d", errno ) ;
+                return false ;
+        }
+        return true ;
+}
+
+// the classic protocol uses unnumbered output reports, hidraw expects those prefixed with a zero report id
+constexpr bool hid_device::write ( report const & report ) const noexcept
+{
+        uti::u8_t buffer [ 1 + FFFB_REPORT_MAX_LEN ] ;
+
+        buffer[ 0 ] = 0 ;
+        memcpy( buffer + 1, report.data, FFFB_REPORT_MAX_LEN ) ;
+
+        ::ssize_t written ;
+
+        do
+        {
+                written = ::write( fd_, buffer, sizeof( buffer ) ) ;
+        }
+        while( written < 0 && errno == EINTR ) ;
+
+        if( written != static_cast< ::ssize_t >( sizeof( buffer ) ) )
+        {
+                FFFB_F_ERR_S( "send_report", "failed writing report, errno %d", errno ) ;
+                return false ;
+        }
+        return true ;
+}
+
+constexpr report hid_device::read () const noexcept
+{
+        report rep {} ;
+
+        ::ssize_t got ;
+
+        do
+        {
+                got = ::read( fd_, rep.data, FFFB_REPORT_MAX_LEN ) ;
+        }
+        while( got < 0 && errno == EINTR ) ;
+
+        if( got < 0 )
+        {
+                FFFB_F_ERR_S( "read_report", "failed reading report, errno %d", errno ) ;
+                return {} ;
+        }
+        return rep ;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace _detail
+{
+
+
+constexpr vector< hid_device > _list_devices ( bool filter, uti::u32_t usage_page, uti::u32_t usage, uti::u32_t vendor_id ) noexcept ;
+
+
+} // namespace _detail
+
+
+// enumerates every hidraw node, prefer find_hid_devices when the kind of device is known
+constexpr vector< hid_device > list_hid_devices () noexcept
+{
+        return _detail::_list_devices( false, 0, 0, 0 ) ;
+}
+
+// filters on the vendor from uevent first, so report descriptors are only parsed for candidates
+constexpr vector< hid_device > find_hid_devices ( uti::u32_t usage_page, uti::u32_t usage, uti::u32_t vendor_id ) noexcept
+{
+        return _detail::_list_devices( true, usage_page, usage, vendor_id ) ;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+
+namespace _detail
+{
+
+
+[[ nodiscard ]] constexpr uti::ssize_t read_sysfs_file ( char const * path, void * buffer, uti::ssize_t capacity ) noexcept
+{
+        int const fd = ::open( path, O_RDONLY | O_CLOEXEC ) ;
+
+        if( fd < 0 ) return -1 ;
+
+        uti::ssize_t len { 0 } ;
+
+        while( len < capacity )
+        {
+                ::ssize_t const got = ::read( fd, static_cast< char * >( buffer ) + len, capacity - len ) ;
+
+                if( got < 0 && errno == EINTR ) continue ;
+                if( got <= 0 ) break ;
+
+                len += got ;
+        }
+        ::close( fd ) ;
+
+        return len ;
+}
+
+// HID_ID=<bus>:<vendor>:<product>, all hex
+[[ nodiscard ]] constexpr bool parse_hid_id ( char const * uevent, uti::u32_t & vendor_id, uti::u32_t & product_id ) noexcept
+{
+        char const * line = strstr( uevent, "HID_ID=" ) ;
+
+        if( !line ) return false ;
+
+        unsigned int bus     { 0 } ;
+        unsigned int vendor  { 0 } ;
+        unsigned int product { 0 } ;
+
+        if( sscanf( line, "HID_ID=%x:%x:%x", &bus, &vendor, &product ) != 3 ) return false ;
+
+        vendor_id  = vendor  ;
+        product_id = product ;
+
+        return true ;
+}
+
+// the primary usage is the usage in effect when the first application collection opens,
+// which is what IOKit reports as kIOHIDPrimaryUsagePageKey / kIOHIDPrimaryUsageKey
+[[ nodiscard ]] constexpr bool parse_primary_usage ( uti::u8_t const * descriptor, uti::ssize_t len, uti::u32_t & usage_page, uti::u32_t & usage ) noexcept
+{
+        uti::u32_t page { 0 } ;
+        uti::u32_t used { 0 } ;
+
+        uti::ssize_t pos { 0 } ;
+
+        while( pos < len )
+        {
+                uti::u8_t const prefix = descriptor[ pos ] ;
+
+                // long items carry no usage information, skip them whole
+                if( prefix == 0xFE )
+                {
+                        if( pos + 1 >= len ) return false ;
+                        pos += 3 + descriptor[ pos + 1 ] ;
+                        continue ;
+                }
+                uti::ssize_t const size = ( prefix & 0x03 ) == 3 ? 4 : ( prefix & 0x03 ) ;
+                uti::u8_t    const type = ( prefix >> 2 ) & 0x03 ;
+                uti::u8_t    const tag  = ( prefix >> 4 ) & 0x0F ;
+
+                if( pos + 1 + size > len ) return false ;
+
+                uti::u32_t data { 0 } ;
+
+                for( uti::ssize_t i = 0; i < size; ++i )
+                {
+                        data |= static_cast< uti::u32_t >( descriptor[ pos + 1 + i ] ) << ( 8 * i ) ;
+                }
+                pos += 1 + size ;
+
+                if( type == 1 && tag == 0x0 )
+                {
+                        page = data ;
+                }
+                else if( type == 2 && tag == 0x0 )
+                {
+                        // 4 byte usages carry their own page in the upper half
+                        if( size == 4 ) { page = data >> 16 ; used = data & 0xFFFF ; }
+                        else            {                     used = data          ; }
+                }
+                else if( type == 0 && tag == 0xA && data == 0x01 )
+                {
+                        usage_page = page ;
+                        usage      = used ;
+                        return true ;
+                }
+                else if( type == 0 )
+                {
+                        used = 0 ;
+                }
+        }
+        return false ;
+}
+
+constexpr vector< hid_device > _list_devices ( bool filter, uti::u32_t usage_page, uti::u32_t usage, uti::u32_t vendor_id ) noexcept
+{
+        vector< hid_device > devices ;
+
+        DIR * dir = opendir( FFFB_HIDRAW_SYSFS_PATH ) ;
+
+        if( !dir )
+        {
+                FFFB_F_ERR_S( "_list_devices", "failed opening " FFFB_HIDRAW_SYSFS_PATH ", errno %d", errno ) ;
+                return devices ;
+        }
+        char      path [ FFFB_HIDRAW_PATH_LEN       ] ;
+        char    uevent [ FFFB_HIDRAW_UEVENT_LEN     ] ;
+        uti::u8_t desc [ FFFB_HIDRAW_DESCRIPTOR_LEN ] ;
+
+        for( dirent const * entry = readdir( dir ); entry != nullptr; entry = readdir( dir ) )
+        {
+                if( strncmp( entry->d_name, "hidraw", 6 ) != 0 ) continue ;
+
+                snprintf( path, sizeof( path ), FFFB_HIDRAW_SYSFS_PATH "/%s/device/uevent", entry->d_name ) ;
+
+                uti::ssize_t const uevent_len = read_sysfs_file( path, uevent, sizeof( uevent ) - 1 ) ;
+
+                if( uevent_len <= 0 ) continue ;
+                uevent[ uevent_len ] = '\0' ;
+
+                uti::u32_t dev_vendor  { 0 } ;
+                uti::u32_t dev_product { 0 } ;
+
+                if( !parse_hid_id( uevent, dev_vendor, dev_product ) ) continue ;
+
+                if( filter && dev_vendor != vendor_id ) continue ;
+
+                snprintf( path, sizeof( path ), FFFB_HIDRAW_SYSFS_PATH "/%s/device/report_descriptor", entry->d_name ) ;
+
+                uti::ssize_t const desc_len = read_sysfs_file( path, desc, sizeof( desc ) ) ;
+
+                uti::u32_t dev_usage_page { 0 } ;
+                uti::u32_t dev_usage      { 0 } ;
+
+                if( desc_len <= 0 || !parse_primary_usage( desc, desc_len, dev_usage_page, dev_usage ) ) continue ;
+
+                if( filter && ( dev_usage_page != usage_page || dev_usage != usage ) ) continue ;
+
+                snprintf( path, sizeof( path ), FFFB_HIDRAW_DEV_PATH "/%s", entry->d_name ) ;
+
+                devices.emplace_back( path, dev_vendor, dev_product, dev_usage_page, dev_usage ) ;
+        }
+        closedir( dir ) ;
+
+        FFFB_F_DBG_S( "_list_devices", "found %d devices", devices.size() ) ;
+        return devices ;
+}
+
+
+} // namespace _detail
+
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,166 @@
+//
+//
+//      fffb
+//      hid/hidraw/monitor.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/hid/hidraw/device.hxx>
+
+#include <atomic>
+#include <cstring>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define FFFB_MONITOR_POLL_INTERVAL_MS 250
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// watches /dev for hidraw nodes coming and going on its own thread and recounts matching devices on every change.
+// creation and attribute changes both count, udev may only grant access to a new node a moment after creating it.
+// consumers poll generation() and only look at online() when it changed
+
+class hid_monitor
+{
+public:
+        constexpr  hid_monitor () noexcept = default ;
+        constexpr ~hid_monitor () noexcept { stop() ; }
+
+        hid_monitor             ( hid_monitor const & ) = delete ;
+        hid_monitor & operator= ( hid_monitor const & ) = delete ;
+
+        constexpr bool start ( uti::u32_t _usage_page_, uti::u32_t _usage_, uti::u32_t _vendor_id_ ) noexcept ;
+        constexpr void stop  (                                                                   ) noexcept ;
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_.load( std::memory_order_acquire ) ; }
+
+        // bumped on every change to a hidraw node
+        [[ nodiscard ]] constexpr uti::u64_t generation () const noexcept { return generation_.load( std::memory_order_acquire ) ; }
+
+        [[ nodiscard ]] constexpr bool online () const noexcept { return present_.load( std::memory_order_acquire ) > 0 ; }
+private:
+        uti::u32_t usage_page_ { 0 } ;
+        uti::u32_t usage_      { 0 } ;
+        uti::u32_t  vendor_id_ { 0 } ;
+
+        int inotify_fd_ { -1 } ;
+
+        pthread_t thread_ {} ;
+
+        std::atomic< bool >       running_    { false } ;
+        std::atomic< uti::i32_t > present_    {     0 } ;
+        std::atomic< uti::u64_t > generation_ {     0 } ;
+
+        constexpr void _rescan () noexcept ;
+
+        static constexpr void * _run ( void * _self_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool hid_monitor::start ( uti::u32_t _usage_page_, uti::u32_t _usage_, uti::u32_t _vendor_id_ ) noexcept
+{
+        if( running() ) return true ;
+
+        usage_page_ = _usage_page_ ;
+        usage_      = _usage_      ;
+         vendor_id_ =  _vendor_id_ ;
+
+        inotify_fd_ = inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) ;
+
+        if( inotify_fd_ < 0 || inotify_add_watch( inotify_fd_, FFFB_HIDRAW_DEV_PATH, IN_CREATE | IN_DELETE | IN_ATTRIB ) < 0 )
+        {
+                FFFB_F_ERR_S( "hid_monitor::start", "failed watching " FFFB_HIDRAW_DEV_PATH ", errno %d", errno ) ;
+
+                if( inotify_fd_ >= 0 ) ::close( inotify_fd_ ) ;
+                inotify_fd_ = -1 ;
+                return false ;
+        }
+        _rescan() ;
+
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                FFFB_F_ERR_S( "hid_monitor::start", "failed spawning monitor thread" ) ;
+                running_.store( false, std::memory_order_release ) ;
+
+                ::close( inotify_fd_ ) ;
+                inotify_fd_ = -1 ;
+                return false ;
+        }
+        FFFB_F_DBG_S( "hid_monitor::start", "monitor thread started" ) ;
+        return true ;
+}
+
+constexpr void hid_monitor::stop () noexcept
+{
+        if( !running() ) return ;
+
+        running_.store( false, std::memory_order_release ) ;
+        pthread_join( thread_, nullptr ) ;
+
+        ::close( inotify_fd_ ) ;
+        inotify_fd_ = -1 ;
+
+        FFFB_F_DBG_S( "hid_monitor::stop", "monitor thread stopped" ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void hid_monitor::_rescan () noexcept
+{
+        uti::i32_t const present = static_cast< uti::i32_t >( find_hid_devices( usage_page_, usage_, vendor_id_ ).size() ) ;
+        uti::i32_t const before  = present_.exchange( present, std::memory_order_acq_rel ) ;
+
+        generation_.fetch_add( 1, std::memory_order_acq_rel ) ;
+
+        if     ( present > before ) FFFB_F_INFO_S( "hid_monitor", "wheel connected"    ) ;
+        else if( present < before ) FFFB_F_WARN_S( "hid_monitor", "wheel disconnected" ) ;
+}
+
+constexpr void * hid_monitor::_run ( void * _self_ ) noexcept
+{
+        hid_monitor * self = static_cast< hid_monitor * >( _self_ ) ;
+
+        alignas( inotify_event ) char buffer [ 4096 ] ;
+
+        while( self->running() )
+        {
+                pollfd pfd { self->inotify_fd_, POLLIN, 0 } ;
+
+                if( poll( &pfd, 1, FFFB_MONITOR_POLL_INTERVAL_MS ) <= 0 ) continue ;
+
+                bool relevant { false } ;
+
+                for( ::ssize_t len = ::read( self->inotify_fd_, buffer, sizeof( buffer ) ); len > 0; len = ::read( self->inotify_fd_, buffer, sizeof( buffer ) ) )
+                {
+                        for( char const * ptr = buffer; ptr < buffer + len; )
+                        {
+                                inotify_event const * event = reinterpret_cast< inotify_event const * >( ptr ) ;
+
+                                if( event->len > 0 && strncmp( event->name, "hidraw", 6 ) == 0 ) relevant = true ;
+
+                                ptr += sizeof( inotify_event ) + event->len ;
+                        }
+                }
+                if( relevant ) self->_rescan() ;
+        }
+        return nullptr ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,152 @@
+//
+//
+//      fffb
+//      hid/hidraw/reader.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/hid/report.hxx>
+#include <fffb/hid/hidraw/device.hxx>
+
+#include <atomic>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define FFFB_READER_POLL_INTERVAL_MS 250
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// blocking reads on a second, read only fd of the wheel's hidraw node, on their own thread.
+// every open fd gets its own copy of each input report, so this never steals reports from the session fd.
+// the poll timeout only bounds how long stop() waits, reports are delivered as soon as they arrive
+
+class hid_reader
+{
+public:
+        constexpr  hid_reader () noexcept = default ;
+        constexpr ~hid_reader () noexcept { stop() ; }
+
+        hid_reader             ( hid_reader const & ) = delete ;
+        hid_reader & operator= ( hid_reader const & ) = delete ;
+
+        constexpr bool start ( hid_device const & _device_, input_report_sink _sink_, void * _context_ ) noexcept ;
+        constexpr void stop  (                                                                         ) noexcept ;
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_.load( std::memory_order_acquire ) ; }
+private:
+        int fd_ { -1 } ;
+
+        input_report_sink sink_    { nullptr } ;
+        void *            context_ { nullptr } ;
+
+        pthread_t thread_ {} ;
+
+        std::atomic< bool > running_ { false } ;
+
+        static constexpr void * _run ( void * _self_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool hid_reader::start ( hid_device const & _device_, input_report_sink _sink_, void * _context_ ) noexcept
+{
+        if( running() ) return true ;
+
+        // joins a thread that already gave up on a node that went away
+        stop() ;
+
+        fd_ = ::open( _device_.node(), O_RDONLY | O_CLOEXEC | O_NONBLOCK ) ;
+
+        if( fd_ < 0 )
+        {
+                FFFB_F_ERR_S( "hid_reader::start", "failed opening %s for reading, errno %d", log_copy( _device_.node() ), errno ) ;
+                return false ;
+        }
+        sink_    = _sink_    ;
+        context_ = _context_ ;
+
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                FFFB_F_ERR_S( "hid_reader::start", "failed spawning reader thread" ) ;
+                running_.store( false, std::memory_order_release ) ;
+
+                ::close( fd_ ) ;
+                fd_ = -1 ;
+                return false ;
+        }
+        FFFB_F_DBG_S( "hid_reader::start", "reader thread started" ) ;
+        return true ;
+}
+
+constexpr void hid_reader::stop () noexcept
+{
+        if( fd_ < 0 ) return ;
+
+        running_.store( false, std::memory_order_release ) ;
+        pthread_join( thread_, nullptr ) ;
+
+        ::close( fd_ ) ;
+        fd_ = -1 ;
+
+        FFFB_F_DBG_S( "hid_reader::stop", "reader thread stopped" ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void * hid_reader::_run ( void * _self_ ) noexcept
+{
+        hid_reader * self = static_cast< hid_reader * >( _self_ ) ;
+
+        uti::u8_t buffer [ FFFB_INPUT_REPORT_MAX_LEN ] ;
+
+        pollfd pfd { self->fd_, POLLIN, 0 } ;
+
+        while( self->running() )
+        {
+                int const ready = ::poll( &pfd, 1, FFFB_READER_POLL_INTERVAL_MS ) ;
+
+                if( ready < 0 && errno == EINTR ) continue ;
+
+                if( ready < 0 || ( pfd.revents & ( POLLERR | POLLHUP | POLLNVAL ) ) )
+                {
+                        // the node went away, the monitor takes it from here
+                        FFFB_F_WARN_S( "hid_reader", "hidraw node closed, stopping reads" ) ;
+                        break ;
+                }
+                if( ready == 0 ) continue ;
+
+                // drain everything queued since the last wakeup, each report is delivered with its own receive time
+                for( ;; )
+                {
+                        ::ssize_t const got = ::read( self->fd_, buffer, sizeof( buffer ) ) ;
+
+                        if( got < 0 && errno == EINTR ) continue ;
+                        if( got <= 0 ) break ;
+
+                        self->sink_( self->context_, buffer, got, monotonic_now() ) ;
+                }
+        }
+        self->running_.store( false, std::memory_order_release ) ;
+
+        return nullptr ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
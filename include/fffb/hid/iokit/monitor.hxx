@@ -0,0 +1,158 @@
+//
+//
+//      fffb
+//      hid/iokit/monitor.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/hid/iokit/device.hxx>
+
+#include <atomic>
+
+#include <pthread.h>
+
+#define FFFB_MONITOR_RUN_LOOP_INTERVAL_S 0.25
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// watches for matching devices arriving and leaving on its own run loop thread.
+// consumers poll generation() and only look at online() when it changed,
+// so the ffb path costs two relaxed loads per tick
+
+class hid_monitor
+{
+public:
+        constexpr  hid_monitor () noexcept = default ;
+        constexpr ~hid_monitor () noexcept { stop() ; }
+
+        hid_monitor             ( hid_monitor const & ) = delete ;
+        hid_monitor & operator= ( hid_monitor const & ) = delete ;
+
+        constexpr bool start ( uti::u32_t _usage_page_, uti::u32_t _usage_, uti::u32_t _vendor_id_ ) noexcept ;
+        constexpr void stop  (                                                                   ) noexcept ;
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_.load( std::memory_order_acquire ) ; }
+
+        // bumped on every arrival and removal
+        [[ nodiscard ]] constexpr uti::u64_t generation () const noexcept { return generation_.load( std::memory_order_acquire ) ; }
+
+        [[ nodiscard ]] constexpr bool online () const noexcept { return present_.load( std::memory_order_acquire ) > 0 ; }
+private:
+        uti::u32_t usage_page_ { 0 } ;
+        uti::u32_t usage_      { 0 } ;
+        uti::u32_t  vendor_id_ { 0 } ;
+
+        pthread_t thread_ {} ;
+
+        std::atomic< bool >       running_    { false } ;
+        std::atomic< uti::i32_t > present_    {     0 } ;
+        std::atomic< uti::u64_t > generation_ {     0 } ;
+
+        static constexpr void * _run ( void * _self_ ) noexcept ;
+
+        static constexpr void _on_match  ( void * _context_, apple::io_result _result_, void * _sender_, apple::hid_device * _device_ ) noexcept ;
+        static constexpr void _on_remove ( void * _context_, apple::io_result _result_, void * _sender_, apple::hid_device * _device_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool hid_monitor::start ( uti::u32_t _usage_page_, uti::u32_t _usage_, uti::u32_t _vendor_id_ ) noexcept
+{
+        if( running() ) return true ;
+
+        usage_page_ = _usage_page_ ;
+        usage_      = _usage_      ;
+         vendor_id_ =  _vendor_id_ ;
+
+        present_.store( 0, std::memory_order_relaxed ) ;
+
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                FFFB_F_ERR_S( "hid_monitor::start", "failed spawning monitor thread" ) ;
+                running_.store( false, std::memory_order_release ) ;
+                return false ;
+        }
+        FFFB_F_DBG_S( "hid_monitor::start", "monitor thread started" ) ;
+        return true ;
+}
+
+constexpr void hid_monitor::stop () noexcept
+{
+        if( !running() ) return ;
+
+        running_.store( false, std::memory_order_release ) ;
+        pthread_join( thread_, nullptr ) ;
+
+        FFFB_F_DBG_S( "hid_monitor::stop", "monitor thread stopped" ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void * hid_monitor::_run ( void * _self_ ) noexcept
+{
+        hid_monitor * self = static_cast< hid_monitor * >( _self_ ) ;
+
+        apple::hid_manager * manager  = IOHIDManagerCreate( kCFAllocatorDefault, kIOHIDManagerOptionNone ) ;
+        apple::dictionary  * matching = _detail::_create_matching( self->usage_page_, self->usage_, self->vendor_id_ ) ;
+
+        IOHIDManagerSetDeviceMatching( manager, matching ) ;
+        if( matching ) CFRelease( matching ) ;
+
+        IOHIDManagerRegisterDeviceMatchingCallback( manager, _on_match , self ) ;
+        IOHIDManagerRegisterDeviceRemovalCallback ( manager, _on_remove, self ) ;
+
+        IOHIDManagerScheduleWithRunLoop( manager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode ) ;
+
+        // the wheel holds the seized session, the monitor only needs to observe
+        IOHIDManagerOpen( manager, kIOHIDOptionsTypeNone ) ;
+
+        while( self->running() )
+        {
+                CFRunLoopRunInMode( kCFRunLoopDefaultMode, FFFB_MONITOR_RUN_LOOP_INTERVAL_S, false ) ;
+        }
+        IOHIDManagerUnscheduleFromRunLoop( manager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode ) ;
+        IOHIDManagerClose( manager, kIOHIDManagerOptionNone ) ;
+        CFRelease( manager ) ;
+
+        return nullptr ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void hid_monitor::_on_match ( void * _context_, [[ maybe_unused ]] apple::io_result _result_, [[ maybe_unused ]] void * _sender_, [[ maybe_unused ]] apple::hid_device * _device_ ) noexcept
+{
+        hid_monitor * self = static_cast< hid_monitor * >( _context_ ) ;
+
+        self->present_   .fetch_add( 1, std::memory_order_acq_rel ) ;
+        self->generation_.fetch_add( 1, std::memory_order_acq_rel ) ;
+
+        FFFB_F_INFO_S( "hid_monitor", "wheel connected" ) ;
+}
+
+constexpr void hid_monitor::_on_remove ( void * _context_, [[ maybe_unused ]] apple::io_result _result_, [[ maybe_unused ]] void * _sender_, [[ maybe_unused ]] apple::hid_device * _device_ ) noexcept
+{
+        hid_monitor * self = static_cast< hid_monitor * >( _context_ ) ;
+
+        uti::i32_t present = self->present_.load( std::memory_order_relaxed ) ;
+
+        while( present > 0 && !self->present_.compare_exchange_weak( present, present - 1, std::memory_order_acq_rel ) ) {}
+
+        self->generation_.fetch_add( 1, std::memory_order_acq_rel ) ;
+
+        FFFB_F_WARN_S( "hid_monitor", "wheel disconnected" ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,134 @@
+//
+//
+//      fffb
+//      hid/iokit/reader.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/hid/report.hxx>
+#include <fffb/hid/iokit/device.hxx>
+
+#include <atomic>
+
+#include <pthread.h>
+
+#define FFFB_READER_RUN_LOOP_INTERVAL_S 0.25
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// schedules the wheel on its own run loop thread and gets every input report through IOKit's report callback.
+// the device must already be open, the wheel's seized session is shared with the reader.
+// the run loop timeout only bounds how long stop() waits, reports are delivered as soon as they arrive
+
+class hid_reader
+{
+public:
+        constexpr  hid_reader () noexcept = default ;
+        constexpr ~hid_reader () noexcept { stop() ; }
+
+        hid_reader             ( hid_reader const & ) = delete ;
+        hid_reader & operator= ( hid_reader const & ) = delete ;
+
+        constexpr bool start ( hid_device const & _device_, input_report_sink _sink_, void * _context_ ) noexcept ;
+        constexpr void stop  (                                                                         ) noexcept ;
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_.load( std::memory_order_acquire ) ; }
+private:
+        // holds its own reference, so the handle outlives a wheel that drops the device first
+        hid_device device_ ;
+
+        input_report_sink sink_    { nullptr } ;
+        void *            context_ { nullptr } ;
+
+        // IOKit fills this in place before every callback
+        uti::u8_t buffer_ [ FFFB_INPUT_REPORT_MAX_LEN ] {} ;
+
+        pthread_t thread_ {} ;
+
+        std::atomic< bool > running_ { false } ;
+
+        static constexpr void * _run ( void * _self_ ) noexcept ;
+
+        static constexpr void _on_report ( void * _context_, apple::io_result _result_, void * _sender_, IOHIDReportType _type_,
+                                           uti::u32_t _report_id_, uti::u8_t * _report_, apple::index _len_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool hid_reader::start ( hid_device const & _device_, input_report_sink _sink_, void * _context_ ) noexcept
+{
+        if( running() ) return true ;
+
+        device_  = _device_  ;
+        sink_    = _sink_    ;
+        context_ = _context_ ;
+
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                FFFB_F_ERR_S( "hid_reader::start", "failed spawning reader thread" ) ;
+                running_.store( false, std::memory_order_release ) ;
+                device_ = {} ;
+                return false ;
+        }
+        FFFB_F_DBG_S( "hid_reader::start", "reader thread started" ) ;
+        return true ;
+}
+
+constexpr void hid_reader::stop () noexcept
+{
+        if( !running() ) return ;
+
+        running_.store( false, std::memory_order_release ) ;
+        pthread_join( thread_, nullptr ) ;
+
+        device_ = {} ;
+
+        FFFB_F_DBG_S( "hid_reader::stop", "reader thread stopped" ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void * hid_reader::_run ( void * _self_ ) noexcept
+{
+        hid_reader * self = static_cast< hid_reader * >( _self_ ) ;
+
+        apple::hid_device * device = self->device_.handle() ;
+
+        IOHIDDeviceRegisterInputReportCallback( device, self->buffer_, sizeof( self->buffer_ ), _on_report, self ) ;
+        IOHIDDeviceScheduleWithRunLoop( device, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode ) ;
+
+        while( self->running() )
+        {
+                CFRunLoopRunInMode( kCFRunLoopDefaultMode, FFFB_READER_RUN_LOOP_INTERVAL_S, false ) ;
+        }
+        IOHIDDeviceRegisterInputReportCallback( device, self->buffer_, sizeof( self->buffer_ ), nullptr, nullptr ) ;
+        IOHIDDeviceUnscheduleFromRunLoop( device, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode ) ;
+
+        return nullptr ;
+}
+
+constexpr void hid_reader::_on_report ( void * _context_, apple::io_result _result_, [[ maybe_unused ]] void * _sender_, [[ maybe_unused ]] IOHIDReportType _type_,
+                                        [[ maybe_unused ]] uti::u32_t _report_id_, uti::u8_t * _report_, apple::index _len_ ) noexcept
+{
+        if( _result_ != kIOReturnSuccess || _len_ <= 0 ) return ;
+
+        hid_reader * self = static_cast< hid_reader * >( _context_ ) ;
+
+        self->sink_( self->context_, _report_, static_cast< uti::ssize_t >( _len_ ), monotonic_now() ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
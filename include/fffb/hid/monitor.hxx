@@ -0,0 +1,22 @@
+//
+//
+//      fffb
+//      hid/monitor.hxx
+//
+
+#pragma once
+
+#include <fffb/util/config.hxx>
+
+// every backend provides the same surface:
+//     class hid_monitor - start ( usage_page, usage, vendor_id ) / stop, generation (), online ()
+
+#if   defined( FFFB_HID_BACKEND_IOKIT  )
+#       include <fffb/hid/iokit/monitor.hxx>
+#elif defined( FFFB_HID_BACKEND_HIDRAW )
+#       include <fffb/hid/hidraw/monitor.hxx>
+#elif defined( FFFB_HID_BACKEND_NULL   )
+#       include <fffb/hid/null/monitor.hxx>
+#else
+#       error "fffb: no hid backend selected"
+#endif
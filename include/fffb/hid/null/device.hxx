@@ -0,0 +1,134 @@
+//
+//
+//      fffb
+//      hid/null/device.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/hid/report.hxx>
+
+#include <cstring>
+
+#ifndef   FFFB_NULL_HID_VENDOR_ID
+#define   FFFB_NULL_HID_VENDOR_ID  0x046d
+#endif // FFFB_NULL_HID_VENDOR_ID
+
+#ifndef   FFFB_NULL_HID_PRODUCT_ID
+#define   FFFB_NULL_HID_PRODUCT_ID 0xc24f
+#endif // FFFB_NULL_HID_PRODUCT_ID
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a backend with no hardware behind it, used to run wheel and simulator offline.
+// discovery always finds a single g29, writes go to an optional sink so a caller can capture the report stream
+
+using null_hid_sink = void ( * )( void * context, report const & report ) ;
+
+
+namespace _detail
+{
+
+
+struct null_hid_sink_slot
+{
+        null_hid_sink sink    { nullptr } ;
+        void *        context { nullptr } ;
+} ;
+
+inline null_hid_sink_slot g_null_hid_sink {} ;
+
+
+} // namespace _detail
+
+
+// not synchronized, install before the wheel starts writing
+constexpr void set_null_hid_sink ( null_hid_sink const sink, void * const context ) noexcept
+{
+        _detail::g_null_hid_sink = { sink, context } ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class hid_device
+{
+public:
+        constexpr hid_device () noexcept = default ;
+
+        constexpr hid_device ( device_id_t vendor_id, device_id_t product_id, device_id_t usage_page, device_id_t usage ) noexcept
+                :  vendor_id_( vendor_id )
+                , product_id_( product_id )
+                ,  device_id_( make_device_id( product_id, vendor_id ) )
+                , usage_page_( usage_page )
+                , usage_     ( usage )
+        {}
+
+        [[ nodiscard ]] constexpr operator bool () const noexcept { return device_id_ != 0 ; }
+
+        [[ nodiscard ]] constexpr bool  open () noexcept { open_ = true ; return true ; }
+                        constexpr bool close () noexcept { open_ = false ; return true ; }
+
+        [[ nodiscard ]] constexpr bool write ( report const & report ) const noexcept
+        {
+                if( !open_ ) return false ;
+
+                if( _detail::g_null_hid_sink.sink ) _detail::g_null_hid_sink.sink( _detail::g_null_hid_sink.context, report ) ;
+
+                return true ;
+        }
+        [[ nodiscard ]] constexpr report read () const noexcept { return {} ; }
+
+        [[ nodiscard ]] constexpr device_id_t  vendor_id () const noexcept { return  vendor_id_ ; }
+        [[ nodiscard ]] constexpr device_id_t product_id () const noexcept { return product_id_ ; }
+        [[ nodiscard ]] constexpr device_id_t  device_id () const noexcept { return  device_id_ ; }
+
+        [[ nodiscard ]] constexpr device_id_t usage_page () const noexcept { return usage_page_ ; }
+        [[ nodiscard ]] constexpr device_id_t usage      () const noexcept { return usage_      ; }
+
+        constexpr bool operator== ( hid_device const & other ) const noexcept
+        {
+                return device_id_  == other.device_id_
+                    && usage_page_ == other.usage_page_
+                    && usage_      == other.usage_    ;
+        }
+        constexpr bool operator!= ( hid_device const & other ) const noexcept { return !operator==( other ) ; }
+private:
+        device_id_t  vendor_id_ { 0 } ;
+        device_id_t product_id_ { 0 } ;
+        device_id_t  device_id_ { 0 } ;
+        device_id_t usage_page_ { 0 } ;
+        device_id_t usage_      { 0 } ;
+
+        bool open_ { false } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr vector< hid_device > list_hid_devices () noexcept
+{
+        vector< hid_device > devices ;
+        devices.emplace_back( FFFB_NULL_HID_VENDOR_ID, FFFB_NULL_HID_PRODUCT_ID, 0x01, 0x04 ) ;
+        return devices ;
+}
+
+constexpr vector< hid_device > find_hid_devices ( uti::u32_t usage_page, uti::u32_t usage, uti::u32_t vendor_id ) noexcept
+{
+        vector< hid_device > devices ;
+
+        if( usage_page == 0x01 && usage == 0x04 && vendor_id == FFFB_NULL_HID_VENDOR_ID )
+        {
+                devices.emplace_back( FFFB_NULL_HID_VENDOR_ID, FFFB_NULL_HID_PRODUCT_ID, usage_page, usage ) ;
+        }
+        return devices ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,44 @@
+//
+//
+//      fffb
+//      hid/null/monitor.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the null device never goes away, so there is nothing to watch
+
+class hid_monitor
+{
+public:
+        constexpr  hid_monitor () noexcept = default ;
+        constexpr ~hid_monitor () noexcept = default ;
+
+        hid_monitor             ( hid_monitor const & ) = delete ;
+        hid_monitor & operator= ( hid_monitor const & ) = delete ;
+
+        constexpr bool start ( uti::u32_t, uti::u32_t, uti::u32_t ) noexcept { running_ = true  ; return true ; }
+        constexpr void stop  (                                    ) noexcept { running_ = false ;               }
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_ ; }
+
+        [[ nodiscard ]] constexpr uti::u64_t generation () const noexcept { return 0 ; }
+
+        [[ nodiscard ]] constexpr bool online () const noexcept { return true ; }
+private:
+        bool running_ { false } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,42 @@
+//
+//
+//      fffb
+//      hid/null/reader.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/hid/report.hxx>
+#include <fffb/hid/null/device.hxx>
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the null device never sends input, the sink is simply never called
+
+class hid_reader
+{
+public:
+        constexpr  hid_reader () noexcept = default ;
+        constexpr ~hid_reader () noexcept = default ;
+
+        hid_reader             ( hid_reader const & ) = delete ;
+        hid_reader & operator= ( hid_reader const & ) = delete ;
+
+        constexpr bool start ( hid_device const &, input_report_sink, void * ) noexcept { running_ = true  ; return true ; }
+        constexpr void stop  (                                               ) noexcept { running_ = false ;               }
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_ ; }
+private:
+        bool running_ { false } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
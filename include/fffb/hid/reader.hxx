@@ -0,0 +1,22 @@
+//
+//
+//      fffb
+//      hid/reader.hxx
+//
+
+#pragma once
+
+#include <fffb/util/config.hxx>
+
+// every backend provides the same surface:
+//     class hid_reader - start ( device, sink, context ) / stop, running ()
+
+#if   defined( FFFB_HID_BACKEND_IOKIT  )
+#       include <fffb/hid/iokit/reader.hxx>
+#elif defined( FFFB_HID_BACKEND_HIDRAW )
+#       include <fffb/hid/hidraw/reader.hxx>
+#elif defined( FFFB_HID_BACKEND_NULL   )
+#       include <fffb/hid/null/reader.hxx>
+#else
+#       error "fffb: no hid backend selected"
+#endif
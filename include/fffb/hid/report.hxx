@@ -6,11 +6,14 @@
 
 #pragma once
 
-#include <fffb/util/log.hxx>
 #include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
 
 #define FFFB_REPORT_MAX_LEN 8
 
+// large enough for any input report the supported wheels send
+#define FFFB_INPUT_REPORT_MAX_LEN 64
+
 
 namespace fffb
 {
@@ -22,22 +25,40 @@ struct report
 
         constexpr uti::u8_t       & operator[] ( uti::ssize_t const index )       noexcept { return data[ index ] ; }
         constexpr uti::u8_t const & operator[] ( uti::ssize_t const index ) const noexcept { return data[ index ] ; }
-} ;
 
+        constexpr bool operator== ( report const & other ) const noexcept
+        {
+                for( uti::ssize_t i = 0; i < FFFB_REPORT_MAX_LEN; ++i )
+                {
+                        if( data[ i ] != other.data[ i ] ) return false ;
+                }
+                return true ;
+        }
+        constexpr bool operator!= ( report const & other ) const noexcept { return !operator==( other ) ; }
+} ;
 
-[[ nodiscard ]] constexpr bool write_report ( apple::hid_device * device, report const & report ) noexcept
+// lower goes out first. control reports (stops, downloads, plays, mode changes) keep their order among themselves
+enum class report_priority : uti::u8_t
 {
-        return apple::_try(
-                IOHIDDeviceSetReport( device, kIOHIDReportTypeOutput, time( nullptr ), report.data, FFFB_REPORT_MAX_LEN ),
-                "send_report"
-        ) ;
-}
+        control   ,
+        constant  ,
+        condition ,
+        periodic  ,
+        led       ,
+} ;
 
-[[ nodiscard ]] constexpr report read_report ( apple::hid_device * ) noexcept
+// key 0 never coalesces, otherwise a newer report with the same key replaces an unsent older one.
+// slots is the mask of effect slots the report touches, a control report for a slot is never overtaken by an older update to it
+struct report_tag
 {
-        FFFB_ERR_S( "read_report", "unimplemented" ) ;
-        return {} ;
-}
+        report_priority priority { report_priority::control } ;
+        uti::u8_t            key { 0 } ;
+        uti::u8_t          slots { 0 } ;
+} ;
+
+// receives every input report as it arrives, on the reader's thread.
+// time is the monotonic time the report was received at
+using input_report_sink = void ( * )( void * context, uti::u8_t const * data, uti::ssize_t len, nanoseconds_t time ) ;
 
 
 } // namespace fffb
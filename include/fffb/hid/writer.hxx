@@ -0,0 +1,429 @@
+//
+//
+//      fffb
+//      hid/writer.hxx
+//
+
+#pragma once
+
+#include <fffb/util/log.hxx>
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/util/spsc_queue.hxx>
+#include <fffb/hid/report.hxx>
+
+#include <atomic>
+
+#include <pthread.h>
+
+#ifndef   FFFB_WRITER_QUEUE_LEN
+#define   FFFB_WRITER_QUEUE_LEN 64
+#endif // FFFB_WRITER_QUEUE_LEN
+
+// reports the device accepts per budget interval, 0 disables the budget.
+// the wheels' interrupt out endpoint is polled once per millisecond
+#ifndef   FFFB_WRITER_BUDGET_REPORTS
+#define   FFFB_WRITER_BUDGET_REPORTS 1
+#endif // FFFB_WRITER_BUDGET_REPORTS
+
+#ifndef   FFFB_WRITER_BUDGET_INTERVAL_US
+#define   FFFB_WRITER_BUDGET_INTERVAL_US 1000
+#endif // FFFB_WRITER_BUDGET_INTERVAL_US
+
+// reports waiting for budget, one per coalescing key plus whatever control reports are in flight
+#define FFFB_WRITER_PENDING_LEN 32
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct writer_stats
+{
+        uti::u64_t published ;
+        uti::u64_t   written ;
+        uti::u64_t    failed ;
+        uti::u64_t   dropped ;
+        uti::u64_t  replaced ;
+        uti::u64_t  overruns ;
+        uti::u64_t saturated ;
+        uti::i64_t     depth ;
+        uti::i64_t max_depth ;
+
+        // written reports over the budget of every interval since start, and of the intervals that wrote anything
+        float      utilisation ;
+        float busy_utilisation ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// output stage draining reports to the device on its own thread
+// publish() is the producer side and never blocks, the sink is only ever called from the writer thread.
+// at most FFFB_WRITER_BUDGET_REPORTS go out per budget interval, highest priority first:
+// a refresh still waiting when a newer one for the same slot arrives is replaced rather than sent twice,
+// and when too much is waiting the lowest priority droppable report makes room.
+// a dropped report leaves the device out of step with the producer's cache, dropped() lets it notice
+
+class report_writer
+{
+public:
+        using sink_fn     =       bool (*)( void * context, report const & rep ) ;
+        using classify_fn = report_tag (*)(                 report const & rep ) ;
+
+        constexpr  report_writer () noexcept = default ;
+        constexpr ~report_writer () noexcept { stop() ; }
+
+        report_writer             ( report_writer const & ) = delete ;
+        report_writer & operator= ( report_writer const & ) = delete ;
+
+        // without a classifier every report is a control report, sent in order
+        constexpr bool start ( sink_fn _sink_, classify_fn _classify_, void * _context_ ) noexcept ;
+        constexpr void stop  (                                                         ) noexcept ;
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_.load( std::memory_order_acquire ) ; }
+
+        constexpr bool publish ( report const & _report_                              ) noexcept ;
+        constexpr bool publish ( report const * _reports_, uti::ssize_t const _count_ ) noexcept ;
+
+        // reports lost to a full queue or evicted for budget, monotonic
+        [[ nodiscard ]] constexpr uti::u64_t dropped () const noexcept { return dropped_.load( std::memory_order_acquire ) ; }
+
+        [[ nodiscard ]] constexpr writer_stats stats () const noexcept ;
+
+        constexpr void log_stats ( char const * _scope_ ) const noexcept ;
+private:
+        spsc_queue< report, FFFB_WRITER_QUEUE_LEN > queue_ ;
+
+        sink_fn         sink_ { nullptr } ;
+        classify_fn classify_ { nullptr } ;
+        void *       context_ { nullptr } ;
+
+        struct pending_report
+        {
+                report        rep {       } ;
+                report_tag    tag {       } ;
+                uti::u64_t    seq {     0 } ;
+                bool         used { false } ;
+        } ;
+        // only touched by the writer thread
+        pending_report pending_ [ FFFB_WRITER_PENDING_LEN ] {} ;
+        uti::i64_t     pending_count_ { 0 } ;
+        uti::u64_t     next_seq_      { 0 } ;
+
+        static constexpr nanoseconds_t interval_ns { FFFB_WRITER_BUDGET_INTERVAL_US * 1000ull } ;
+
+        nanoseconds_t interval_start_ { 0 } ;
+        uti::i64_t    credits_        { 0 } ;
+        nanoseconds_t started_        { 0 } ;
+
+        pthread_t thread_ {} ;
+
+        std::atomic< bool       > running_ { false } ;
+        std::atomic< uti::u32_t >  signal_ {     0 } ;
+
+        // set while the writer sleeps on signal_, publishing only pays for a wake-up then
+        std::atomic< bool > parked_ { false } ;
+
+        std::atomic< uti::u64_t > published_ { 0 } ;
+        std::atomic< uti::u64_t >   written_ { 0 } ;
+        std::atomic< uti::u64_t >    failed_ { 0 } ;
+        std::atomic< uti::u64_t >   dropped_ { 0 } ;
+        std::atomic< uti::u64_t >  replaced_ { 0 } ;
+        std::atomic< uti::u64_t >  overruns_ { 0 } ;
+        std::atomic< uti::u64_t > saturated_ { 0 } ;
+        std::atomic< uti::u64_t >      busy_ { 0 } ;
+        std::atomic< uti::i64_t >   waiting_ { 0 } ;
+        std::atomic< uti::i64_t > max_depth_ { 0 } ;
+
+        static constexpr void * _run ( void * _self_ ) noexcept ;
+
+        // moves everything published so far into the pending table
+        constexpr void _collect () noexcept ;
+        constexpr void _admit   ( report const & _report_ ) noexcept ;
+
+        // sends what the current interval's budget allows, returns false when reports are left waiting for the next one
+        constexpr bool _send ( bool _unbudgeted_ ) noexcept ;
+
+        constexpr uti::i64_t _next () const noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool report_writer::start ( sink_fn _sink_, classify_fn _classify_, void * _context_ ) noexcept
+{
+        if( running() ) return true ;
+
+        sink_     = _sink_     ;
+        classify_ = _classify_ ;
+        context_  = _context_  ;
+
+        started_        = monotonic_now() ;
+        interval_start_ = 0 ;
+        credits_        = 0 ;
+
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                FFFB_F_ERR_S( "report_writer::start", "failed spawning writer thread" ) ;
+                running_.store( false, std::memory_order_release ) ;
+                return false ;
+        }
+        FFFB_F_DBG_S( "report_writer::start", "writer thread started" ) ;
+        return true ;
+}
+
+constexpr void report_writer::stop () noexcept
+{
+        if( !running() ) return ;
+
+        running_.store( false, std::memory_order_release ) ;
+
+        signal_.fetch_add( 1, std::memory_order_release ) ;
+        signal_.notify_one() ;
+
+        pthread_join( thread_, nullptr ) ;
+
+        FFFB_F_DBG_S( "report_writer::stop", "writer thread stopped" ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool report_writer::publish ( report const & _report_ ) noexcept
+{
+        return publish( &_report_, 1 ) ;
+}
+
+constexpr bool report_writer::publish ( report const * _reports_, uti::ssize_t const _count_ ) noexcept
+{
+        if( _count_ == 0 ) return true ;
+
+        // the previous batch hasn't been drained yet, writer is falling behind
+        if( !queue_.empty() ) overruns_.fetch_add( 1, std::memory_order_relaxed ) ;
+
+        bool all_queued { true } ;
+
+        for( uti::ssize_t i = 0; i < _count_; ++i )
+        {
+                if( queue_.push( _reports_[ i ] ) )
+                {
+                        published_.fetch_add( 1, std::memory_order_relaxed ) ;
+                }
+                else
+                {
+                        dropped_.fetch_add( 1, std::memory_order_relaxed ) ;
+                        all_queued = false ;
+                }
+        }
+        uti::i64_t const depth = queue_.size() + waiting_.load( std::memory_order_relaxed ) ;
+
+        if( depth > max_depth_.load( std::memory_order_relaxed ) ) max_depth_.store( depth, std::memory_order_relaxed ) ;
+
+        // seq_cst pairs with the writer parking: either it sees the new signal and doesn't sleep,
+        // or this sees it parked and wakes it. no syscall on this thread while the writer keeps up
+        signal_.fetch_add( 1, std::memory_order_seq_cst ) ;
+
+        if( parked_.load( std::memory_order_seq_cst ) ) signal_.notify_one() ;
+
+        return all_queued ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr writer_stats report_writer::stats () const noexcept
+{
+        uti::u64_t const written = written_.load( std::memory_order_relaxed ) ;
+        uti::u64_t const busy    =    busy_.load( std::memory_order_relaxed ) ;
+
+        nanoseconds_t const now       = monotonic_now() ;
+        uti::u64_t    const intervals = started_ && now > started_ ? ( now - started_ ) / interval_ns + 1 : 0 ;
+
+        float const budget = static_cast< float >( FFFB_WRITER_BUDGET_REPORTS ) ;
+
+        return {
+                published_.load( std::memory_order_relaxed )                                   ,
+                written                                                                        ,
+                   failed_.load( std::memory_order_relaxed )                                   ,
+                  dropped_.load( std::memory_order_relaxed )                                   ,
+                 replaced_.load( std::memory_order_relaxed )                                   ,
+                 overruns_.load( std::memory_order_relaxed )                                   ,
+                saturated_.load( std::memory_order_relaxed )                                   ,
+                queue_.size() + waiting_.load( std::memory_order_relaxed )                     ,
+                max_depth_.load( std::memory_order_relaxed )                                   ,
+                budget > 0.0f && intervals ? static_cast< float >( written ) / ( budget * static_cast< float >( intervals ) ) : 0.0f ,
+                budget > 0.0f && busy      ? static_cast< float >( written ) / ( budget * static_cast< float >( busy      ) ) : 0.0f ,
+        } ;
+}
+
+constexpr void report_writer::log_stats ( [[ maybe_unused ]] char const * _scope_ ) const noexcept
+{
+        [[ maybe_unused ]] writer_stats const s = stats() ;
+
+        FFFB_F_INFO_S( _scope_, "writer: published %llu written %llu failed %llu dropped %llu replaced %llu overruns %llu depth %lld max depth %lld",
+                       s.published, s.written, s.failed, s.dropped, s.replaced, s.overruns, s.depth, s.max_depth ) ;
+        FFFB_F_INFO_S( _scope_, "writer: budget %d reports per %d us, utilisation %.1f%% overall %.1f%% while busy, %llu intervals saturated",
+                       FFFB_WRITER_BUDGET_REPORTS, FFFB_WRITER_BUDGET_INTERVAL_US, s.utilisation * 100.0f, s.busy_utilisation * 100.0f, s.saturated ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void * report_writer::_run ( void * _self_ ) noexcept
+{
+        report_writer * self = static_cast< report_writer * >( _self_ ) ;
+
+        while( self->running() )
+        {
+                uti::u32_t const seen = self->signal_.load( std::memory_order_acquire ) ;
+
+                self->_collect() ;
+
+                // out of budget, whatever arrives meanwhile is ranked against what's waiting
+                if( !self->_send( false ) )
+                {
+                        sleep_until( self->interval_start_ + interval_ns ) ;
+                        continue ;
+                }
+                if( self->queue_.empty() && self->running() )
+                {
+                        self->parked_.store( true, std::memory_order_seq_cst ) ;
+                        self->signal_.wait( seen, std::memory_order_seq_cst ) ;
+                        self->parked_.store( false, std::memory_order_relaxed ) ;
+                }
+        }
+        // don't leave stop or reset commands behind
+        self->_collect() ;
+        self->_send( true ) ;
+
+        return nullptr ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void report_writer::_collect () noexcept
+{
+        report rep ;
+
+        while( queue_.pop( rep ) ) _admit( rep ) ;
+
+        waiting_.store( pending_count_, std::memory_order_relaxed ) ;
+}
+
+constexpr void report_writer::_admit ( report const & _report_ ) noexcept
+{
+        report_tag const tag = classify_ ? classify_( _report_ ) : report_tag{} ;
+
+        pending_report * free   { nullptr } ;
+        pending_report * victim { nullptr } ;
+
+        for( auto & entry : pending_ )
+        {
+                if( !entry.used )
+                {
+                        if( !free ) free = &entry ;
+                        continue ;
+                }
+                // an update still waiting for a slot this command touches goes out first, in its original order
+                if( tag.priority == report_priority::control && ( entry.tag.slots & tag.slots ) )
+                {
+                        entry.tag.priority = report_priority::control ;
+                        entry.tag.key      = 0 ;
+                        continue ;
+                }
+                // superseded, keeps its place in line with the newer contents
+                if( tag.key != 0 && entry.tag.key == tag.key )
+                {
+                        entry.rep = _report_ ;
+                        replaced_.fetch_add( 1, std::memory_order_relaxed ) ;
+                        return ;
+                }
+                if( entry.tag.priority >= report_priority::periodic && ( !victim || entry.tag.priority > victim->tag.priority
+                                                                                 || ( entry.tag.priority == victim->tag.priority && entry.seq < victim->seq ) ) )
+                {
+                        victim = &entry ;
+                }
+        }
+        if( !free )
+        {
+                // full, the oldest of the least important droppable reports makes room if it ranks below this one
+                if( !victim || victim->tag.priority <= tag.priority )
+                {
+                        FFFB_F_WARN_S( "report_writer", "pending reports full, dropping report 0x%.2x", _report_.data[ 0 ] ) ;
+                        dropped_.fetch_add( 1, std::memory_order_release ) ;
+                        return ;
+                }
+                dropped_.fetch_add( 1, std::memory_order_release ) ;
+
+                free = victim ;
+                --pending_count_ ;
+        }
+        *free = { _report_, tag, next_seq_++, true } ;
+        ++pending_count_ ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr uti::i64_t report_writer::_next () const noexcept
+{
+        uti::i64_t best { -1 } ;
+
+        for( uti::i64_t i = 0; i < FFFB_WRITER_PENDING_LEN; ++i )
+        {
+                pending_report const & entry = pending_[ i ] ;
+
+                if( !entry.used ) continue ;
+
+                if( best < 0 || entry.tag.priority < pending_[ best ].tag.priority
+                             || ( entry.tag.priority == pending_[ best ].tag.priority && entry.seq < pending_[ best ].seq ) )
+                {
+                        best = i ;
+                }
+        }
+        return best ;
+}
+
+constexpr bool report_writer::_send ( bool const _unbudgeted_ ) noexcept
+{
+        bool const budgeted = FFFB_WRITER_BUDGET_REPORTS > 0 && !_unbudgeted_ ;
+
+        while( pending_count_ > 0 )
+        {
+                if( budgeted )
+                {
+                        nanoseconds_t const now = monotonic_now() ;
+
+                        if( now >= interval_start_ + interval_ns )
+                        {
+                                interval_start_ = now ;
+                                credits_        = FFFB_WRITER_BUDGET_REPORTS ;
+                        }
+                        if( credits_ == 0 )
+                        {
+                                saturated_.fetch_add( 1, std::memory_order_relaxed ) ;
+                                waiting_.store( pending_count_, std::memory_order_relaxed ) ;
+                                return false ;
+                        }
+                        // the first report of an interval marks it busy
+                        if( credits_ == FFFB_WRITER_BUDGET_REPORTS ) busy_.fetch_add( 1, std::memory_order_relaxed ) ;
+
+                        --credits_ ;
+                }
+                pending_report & entry = pending_[ _next() ] ;
+
+                if( sink_( context_, entry.rep ) ) written_.fetch_add( 1, std::memory_order_relaxed ) ;
+                else                                failed_.fetch_add( 1, std::memory_order_relaxed ) ;
+
+                entry.used = false ;
+                --pending_count_ ;
+        }
+        waiting_.store( 0, std::memory_order_relaxed ) ;
+
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,154 @@
+//
+//
+//      fffb
+//      joy/input.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/util/seqlock.hxx>
+#include <fffb/hid/report.hxx>
+#include <fffb/force/shaping.hxx>
+
+#include <cmath>
+
+#ifndef   FFFB_INPUT_VELOCITY_CUTOFF_HZ
+#define   FFFB_INPUT_VELOCITY_CUTOFF_HZ 30.0f
+#endif // FFFB_INPUT_VELOCITY_CUTOFF_HZ
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the physical state of the wheel as of its last input report.
+// position is normalized to [-1, 1] over the 900 degree range with positive to the left, same as the game's steering channel.
+// velocity is in the same units per second, pedals are 0 released to 1 fully pressed
+
+struct wheel_input
+{
+        float position { 0.0f } ;
+        float velocity { 0.0f } ;
+        float throttle { 0.0f } ;
+        float    brake { 0.0f } ;
+        float   clutch { 0.0f } ;
+
+        // monotonic receive time of the report and how many reports were parsed before it
+        nanoseconds_t timestamp { 0 } ;
+        uti::u64_t     sequence { 0 } ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the g29 and g923 input report, unnumbered:
+//     0-3 buttons and hat, 4-5 steering little endian with 0 at full left, 6 throttle, 7 brake, 8 clutch.
+// pedals read 0xff released and 0x00 fully pressed
+
+struct logitech_input_layout
+{
+        static constexpr uti::ssize_t steering_offset { 4 } ;
+        static constexpr uti::ssize_t throttle_offset { 6 } ;
+        static constexpr uti::ssize_t    brake_offset { 7 } ;
+        static constexpr uti::ssize_t   clutch_offset { 8 } ;
+
+        static constexpr uti::ssize_t min_len { 9 } ;
+} ;
+
+// fills position and pedals, returns false for reports too short to be a wheel state report
+[[ nodiscard ]] constexpr bool parse_input_report ( uti::u8_t const * _data_, uti::ssize_t const _len_, wheel_input & _input_ ) noexcept
+{
+        using layout = logitech_input_layout ;
+
+        if( _len_ < layout::min_len ) return false ;
+
+        uti::u16_t const raw = static_cast< uti::u16_t >( _data_[ layout::steering_offset ] | ( _data_[ layout::steering_offset + 1 ] << 8 ) ) ;
+
+        _input_.position = ( 32767.5f - static_cast< float >( raw ) ) / 32767.5f ;
+
+        _input_.throttle = static_cast< float >( 255 - _data_[ layout::throttle_offset ] ) / 255.0f ;
+        _input_.brake    = static_cast< float >( 255 - _data_[ layout::   brake_offset ] ) / 255.0f ;
+        _input_.clutch   = static_cast< float >( 255 - _data_[ layout::  clutch_offset ] ) / 255.0f ;
+
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// turns the input report stream into wheel_input samples and publishes the latest one.
+// on_report() runs on the reader thread only, latest() may be called from any thread and never blocks it.
+// velocity is differentiated over receive times and low-passed, a raw 16 bit difference over 1-2 ms is mostly noise
+
+class wheel_input_tracker
+{
+public:
+        constexpr wheel_input_tracker () noexcept = default ;
+
+        wheel_input_tracker             ( wheel_input_tracker const & ) = delete ;
+        wheel_input_tracker & operator= ( wheel_input_tracker const & ) = delete ;
+
+        // called by the reader before it starts, so a stale velocity doesn't survive a reconnect
+        constexpr void reset () noexcept { last_ = {} ; primed_ = false ; }
+
+        [[ nodiscard ]] constexpr wheel_input latest () const noexcept { return sample_.load() ; }
+
+        // number of samples published so far, 0 means the wheel hasn't reported yet
+        [[ nodiscard ]] constexpr uti::u64_t generation () const noexcept { return sample_.generation() ; }
+
+        // matches input_report_sink
+        static constexpr void on_report ( void * _self_, uti::u8_t const * _data_, uti::ssize_t _len_, nanoseconds_t _time_ ) noexcept ;
+private:
+        seqlock< wheel_input > sample_ ;
+
+        wheel_input last_   {       } ;
+        bool        primed_ { false } ;
+
+        // a gap this long means reports stopped, differentiating across it would only produce a spike
+        static constexpr nanoseconds_t max_gap_ns { 50 * 1000 * 1000 } ;
+
+        constexpr void _update ( wheel_input & _input_, nanoseconds_t _time_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void wheel_input_tracker::on_report ( void * _self_, uti::u8_t const * _data_, uti::ssize_t const _len_, nanoseconds_t const _time_ ) noexcept
+{
+        wheel_input_tracker * self = static_cast< wheel_input_tracker * >( _self_ ) ;
+
+        wheel_input input {} ;
+
+        if( !parse_input_report( _data_, _len_, input ) ) return ;
+
+        self->_update( input, _time_ ) ;
+        self->sample_.store( input ) ;
+}
+
+constexpr void wheel_input_tracker::_update ( wheel_input & _input_, nanoseconds_t const _time_ ) noexcept
+{
+        _input_.timestamp = _time_ ;
+        _input_.sequence  = last_.sequence + primed_ ;
+
+        if( primed_ && _time_ > last_.timestamp && _time_ - last_.timestamp < max_gap_ns )
+        {
+                float const dt    = static_cast< float >( _time_ - last_.timestamp ) / static_cast< float >( ns_per_sec ) ;
+                float const raw   = ( _input_.position - last_.position ) / dt ;
+                float const alpha = 1.0f - std::exp( -two_pi * FFFB_INPUT_VELOCITY_CUTOFF_HZ * dt ) ;
+
+                _input_.velocity = last_.velocity + alpha * ( raw - last_.velocity ) ;
+        }
+        else
+        {
+                _input_.velocity = 0.0f ;
+        }
+        last_   = _input_ ;
+        primed_ = true    ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
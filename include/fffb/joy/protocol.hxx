@@ -11,8 +11,13 @@
 #include <fffb/hid/report.hxx>
 #include <fffb/hid/device.hxx>
 
+#include <uti/core/container/static_vector.hxx>
+
 #define FFFB_FORCE_MAX_PARAMS 7
 
+// worst case for a single tick: a stop, a download or refresh per slot, a play and an led or autocenter command
+#define FFFB_PROTOCOL_MAX_TICK_REPORTS 8
+
 #define FFFB_FORCE_SLOT_CONSTANT   0b0001
 #define FFFB_FORCE_SLOT_SPRING     0b0011
 #define FFFB_FORCE_SLOT_DAMPER     0b0100
@@ -38,6 +43,10 @@ constexpr uti::array< uti::u32_t, 2 > known_wheel_device_ids
 
 ////////////////////////////////////////////////////////////////////////////////
 
+using report_batch = uti::static_vector< report, FFFB_PROTOCOL_MAX_TICK_REPORTS > ;
+
+////////////////////////////////////////////////////////////////////////////////
+
 enum class force_type
 {
         CONSTANT  ,
@@ -47,13 +56,6 @@ enum class force_type
         COUNT     ,
 } ;
 
-struct force_params
-{
-        uti::u8_t   slot ;
-        bool     enabled ;
-        uti::u8_t params [ FFFB_FORCE_MAX_PARAMS ] ;
-} ;
-
 struct constant_force_params
 {
         uti::u8_t      slot { FFFB_FORCE_SLOT_CONSTANT } ;
@@ -100,34 +102,8 @@ struct trapezoid_force_params
         uti::u8_t       padding [ FFFB_FORCE_MAX_PARAMS - 6 ] ;
 } ;
 
-struct force
-{
-        force_type type ;
-        union
-        {
-                          force_params    params ;
-                 constant_force_params  constant ;
-                   spring_force_params    spring ;
-                   damper_force_params    damper ;
-                trapezoid_force_params trapezoid ;
-        } ;
-} ;
-
 ////////////////////////////////////////////////////////////////////////////////
 
-enum class command_type
-{
-        AUTO_ON       ,
-        AUTO_OFF      ,
-        AUTO_SET      ,
-        LED_SET       ,
-        DL_FORCE      ,
-        PLAY_FORCE    ,
-        REFRESH_FORCE ,
-        STOP_FORCE    ,
-        COUNT         ,
-} ;
-
 enum class ffb_protocol
 {
         logitech_classic ,
@@ -135,335 +111,164 @@ enum class ffb_protocol
         count
 } ;
 
-////////////////////////////////////////////////////////////////////////////////
-
-class protocol
-{
-public:
-        static constexpr report build_report ( ffb_protocol const protocol, command_type const cmd_type, uti::u8_t slots ) noexcept ;
-        static constexpr report build_report ( ffb_protocol const protocol, command_type const cmd_type, force const & f ) noexcept ;
-
-        static constexpr report set_led_pattern ( ffb_protocol const protocol, uti::u8_t pattern ) noexcept ;
-        static constexpr report set_range      ( ffb_protocol const protocol, uti::u16_t range ) noexcept ;
-
-        static constexpr report disable_autocenter ( ffb_protocol const protocol, uti::u8_t slots ) noexcept ;
-        static constexpr report  enable_autocenter ( ffb_protocol const protocol, uti::u8_t slots ) noexcept ;
-
-        static constexpr report set_autocenter ( ffb_protocol const protocol, force const & force ) noexcept ;
-        static constexpr report download_force ( ffb_protocol const protocol, force const & force ) noexcept ;
-
-        static constexpr report    play_force ( ffb_protocol const protocol, uti::u8_t slots ) noexcept ;
-        static constexpr report refresh_force ( ffb_protocol const protocol, force const & f ) noexcept ;
-        static constexpr report    stop_force ( ffb_protocol const protocol, uti::u8_t slots ) noexcept ;
-
-        static constexpr vector< report > init_sequence ( ffb_protocol const protocol, uti::u32_t device_id ) noexcept ;
-private:
-        static constexpr report  _constant_force ( ffb_protocol const protocol, force const & force ) noexcept ;
-        static constexpr report    _spring_force ( ffb_protocol const protocol, force const & force ) noexcept ;
-        static constexpr report    _damper_force ( ffb_protocol const protocol, force const & force ) noexcept ;
-        static constexpr report _trapezoid_force ( ffb_protocol const protocol, force const & force ) noexcept ;
-} ;
-
 constexpr ffb_protocol get_supported_protocol ( hid_device const & device ) noexcept ;
 
-////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr report protocol::build_report ( ffb_protocol const protocol, command_type const cmd_type, uti::u8_t slots ) noexcept
-{
-        switch( cmd_type )
-        {
-                case command_type::AUTO_OFF      : return disable_autocenter( protocol, slots ) ;
-                case command_type::AUTO_ON       : return  enable_autocenter( protocol, slots ) ;
-                case command_type::PLAY_FORCE    : return         play_force( protocol, slots ) ;
-                case command_type::STOP_FORCE    : return         stop_force( protocol, slots ) ;
-                case command_type::AUTO_SET      : [[ fallthrough ]] ;
-                case command_type::DL_FORCE      : [[ fallthrough ]] ;
-                case command_type::REFRESH_FORCE :
-                        FFFB_F_ERR_S( "protocol::build_report", "selected command requires parameters" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::build_report", "unknown command" ) ;
-                        return {} ;
-        }
-}
+// protocols are policies: a wheel is instantiated for exactly one of them and every encoder is picked at compile time.
+// a policy provides an id, the per-effect encoders and the fixed reports the wheel sends as they are
 
-constexpr report protocol::build_report ( ffb_protocol const protocol, command_type const cmd_type, force const & f ) noexcept
+namespace _detail
 {
-        switch( cmd_type )
-        {
-                case command_type::AUTO_SET      : return     set_autocenter( protocol, f ) ;
-                case command_type::DL_FORCE      : return     download_force( protocol, f ) ;
-                case command_type::REFRESH_FORCE : return      refresh_force( protocol, f ) ;
-                case command_type::AUTO_ON       : [[ fallthrough ]] ;
-                case command_type::AUTO_OFF      : [[ fallthrough ]] ;
-                case command_type::PLAY_FORCE    : [[ fallthrough ]] ;
-                case command_type::STOP_FORCE    :
-                        FFFB_F_ERR_S( "protocol::build_report", "excess parameters for selected command" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::build_report", "unknown command" ) ;
-                        return {} ;
-        }
-}
 
-constexpr report protocol::set_led_pattern ( ffb_protocol const protocol, uti::u8_t pattern ) noexcept
-{
-        pattern = pattern & 0b00011111 ;
 
-        switch( protocol )
+struct logitech_classic_encoders
+{
+        static constexpr report set_led_pattern ( uti::u8_t const pattern ) noexcept
         {
-                case ffb_protocol::logitech_classic : return { 0xF8, 0x12, pattern, 0x00 } ;
-                case ffb_protocol::logitech_hidpp   : return {} ;
-                        FFFB_F_ERR_S( "protocol::set_led_pattern", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::set_led_pattern", "protocol not supported" ) ;
-                        return {} ;
+                return { 0xF8, 0x12, uti::u8_t( pattern & 0b00011111 ), 0x00 } ;
         }
-}
+        static constexpr report set_range ( uti::u16_t const range ) noexcept
+        {
+                uti::u8_t range_lo = static_cast< uti::u8_t >( range & 0x00FF ) ;
+                uti::u8_t range_hi = static_cast< uti::u8_t >( ( range & 0xFF00 ) >> 8 ) ;
 
-constexpr report protocol::set_range ( ffb_protocol const protocol, uti::u16_t range ) noexcept
-{
-        uti::u8_t range_lo = static_cast< uti::u8_t >( range & 0x00FF ) ;
-        uti::u8_t range_hi = static_cast< uti::u8_t >( ( range & 0xFF00 ) >> 8 ) ;
+                return { 0xF8, 0x81, range_lo, range_hi, 0x00, 0x00, 0x00 } ;
+        }
+        static constexpr report disable_autocenter ( uti::u8_t const slots ) noexcept { return { uti::u8_t( ( slots << 4 ) | 0x05 ) } ; }
+        static constexpr report  enable_autocenter ( uti::u8_t const slots ) noexcept { return { uti::u8_t( ( slots << 4 ) | 0x04 ) } ; }
 
-        switch( protocol )
+        static constexpr report set_autocenter ( spring_force_params const & f ) noexcept
         {
-                case ffb_protocol::logitech_classic : return { 0xF8, 0x81, range_lo, range_hi, 0x00, 0x00, 0x00 } ;
-                case ffb_protocol::logitech_hidpp   :
-                        FFFB_F_ERR_S( "protocol::set_range", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::set_range", "protocol not supported" ) ;
-                        return {} ;
+                uti::u8_t command = ( f.slot << 4 ) | 0x0e ;
+
+                return { command, 0x00, uti::u8_t( f.slope_left | 0b0111 ), uti::u8_t( f.slope_right | 0b0111 ), f.amplitude, 0x00 } ;
         }
-}
 
-constexpr report protocol::disable_autocenter ( ffb_protocol const protocol, uti::u8_t slots ) noexcept
-{
-        uti::u8_t command = ( slots << 4 ) | 0x05 ;
+        static constexpr report play ( uti::u8_t const slots ) noexcept { return { uti::u8_t( ( slots << 4 ) | 0x02 ), 0x00 } ; }
+        static constexpr report stop ( uti::u8_t const slots ) noexcept { return { uti::u8_t( ( slots << 4 ) | 0x03 ), 0x00 } ; }
 
-        switch( protocol )
-        {
-                case ffb_protocol::logitech_classic : return { command } ;
-                case ffb_protocol::logitech_hidpp   :
-                        FFFB_F_ERR_S( "protocol::disable_autocenter", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::disable_autocenter", "protocol not supported" ) ;
-                        return {} ;
-        }
-}
+        // one overload per effect, overload resolution replaces the switch on force_type
 
-constexpr report protocol::enable_autocenter ( ffb_protocol const protocol, uti::u8_t slots ) noexcept
-{
-        uti::u8_t command = ( slots << 4 ) | 0x04 ;
+        static constexpr report download ( constant_force_params const & f ) noexcept
+        {
+                uti::u8_t command   = f.slot << 4 ;
+                uti::u8_t amplitude = f.amplitude ;
 
-        switch( protocol )
+                return { command, 0x00, amplitude, amplitude, amplitude, amplitude, 0x00 } ;
+        }
+        static constexpr report download ( spring_force_params const & f ) noexcept
         {
-                case ffb_protocol::logitech_classic : return { command } ;
-                case ffb_protocol::logitech_hidpp   :
-                        FFFB_F_ERR_S( "protocol::enable_autocenter", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::enable_autocenter", "protocol not supported" ) ;
-                        return {} ;
+                uti::u8_t command = f.slot << 4 ;
+
+                uti::u8_t slope_left   = f.slope_left   & 0b0111 ;
+                uti::u8_t slope_right  = f.slope_right  & 0b0111 ;
+                uti::u8_t invert_left  = f.invert_left  & 0b0001 ;
+                uti::u8_t invert_right = f.invert_right & 0b0001 ;
+
+                return { command, 0x01,
+                         f.dead_start, f.dead_end,
+                         uti::u8_t( (  slope_right << 4 ) |  slope_left ),
+                         uti::u8_t( ( invert_right << 4 ) | invert_left ),
+                         f.amplitude } ;
         }
-}
-
-constexpr report protocol::set_autocenter ( ffb_protocol const protocol, force const & f ) noexcept
-{
-        uti::u8_t command = ( f.params.slot << 4 ) | 0x0e ;
+        static constexpr report download ( damper_force_params const & f ) noexcept
+        {
+                uti::u8_t command = f.slot << 4 ;
 
-        uti::u8_t   slope_l = f.spring.slope_left  | 0b0111 ;
-        uti::u8_t   slope_r = f.spring.slope_right | 0b0111 ;
-        uti::u8_t amplitude = f.spring.amplitude            ;
+                uti::u8_t slope_left   = f.slope_left   & 0b0111 ;
+                uti::u8_t slope_right  = f.slope_right  & 0b0111 ;
+                uti::u8_t invert_left  = f.invert_left  & 0b0001 ;
+                uti::u8_t invert_right = f.invert_right & 0b0001 ;
 
-        switch( protocol )
+                return { command, 0x02, slope_left, invert_left, slope_right, invert_right, 0x00 } ;
+        }
+        static constexpr report download ( trapezoid_force_params const & f ) noexcept
         {
-                case ffb_protocol::logitech_classic : return { command, 0x00, slope_l, slope_r, amplitude, 0x00 } ;
-                case ffb_protocol::logitech_hidpp   :
-                        FFFB_F_ERR_S( "protocol::set_autocenter", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::set_autocenter", "protocol not supported" ) ;
-                        return {} ;
+                uti::u8_t command = f.slot << 4 ;
+                uti::u8_t    dxdy = ( f.slope_step_x << 4 ) | f.slope_step_y ;
+
+                return { command, 0x06, f.amplitude_max, f.amplitude_min, f.t_at_max, f.t_at_min, dxdy } ;
         }
-}
 
-constexpr report protocol::download_force ( ffb_protocol const protocol, force const & f ) noexcept
-{
-        switch( f.type )
+        // a refresh is the download with the command nibble swapped
+        template< typename Params >
+        static constexpr report refresh ( Params const & f ) noexcept
         {
-                case force_type:: CONSTANT : return  _constant_force( protocol, f ) ;
-                case force_type::   SPRING : return    _spring_force( protocol, f ) ;
-                case force_type::   DAMPER : return    _damper_force( protocol, f ) ;
-                case force_type::TRAPEZOID : return _trapezoid_force( protocol, f ) ;
-                default:
-                        FFFB_F_ERR_S( "protocol::download_force", "force type not supported" ) ;
-                        return {} ;
-        }
-}
+                report rep = download( f ) ;
 
-constexpr report protocol::play_force ( ffb_protocol const protocol, uti::u8_t slots ) noexcept
-{
-        uti::u8_t command = ( slots << 4 ) | 0x02 ;
+                rep.data[ 0 ] &= 0xF0 ;
+                rep.data[ 0 ] |= 0x0C ;
 
-        switch( protocol )
-        {
-                case ffb_protocol::logitech_classic: return { command, 0x00 } ;
-                        break ;
-                case ffb_protocol::logitech_hidpp:
-                        FFFB_F_ERR_S( "protocol::play_force", "protocol not implemented" ) ;
-                        return {} ;
-                default:
-                        FFFB_F_ERR_S( "protocol::play_force", "protocol not supported" ) ;
-                        return {} ;
+                return rep ;
         }
-}
+} ;
 
-constexpr report protocol::refresh_force ( ffb_protocol const protocol, force const & f ) noexcept
-{
-        report rep = download_force( protocol, f ) ;
 
-        rep.data[ 0 ] &= 0xF0 ;
-        rep.data[ 0 ] |= 0x0C ;
+} // namespace _detail
 
-        return rep ;
-}
+////////////////////////////////////////////////////////////////////////////////
 
-constexpr report protocol::stop_force ( ffb_protocol const protocol, uti::u8_t slots ) noexcept
+struct logitech_classic : _detail::logitech_classic_encoders
 {
-        uti::u8_t command = ( slots << 4 ) | 0x03 ;
+        static constexpr ffb_protocol id { ffb_protocol::logitech_classic } ;
 
-        switch( protocol )
-        {
-                case ffb_protocol::logitech_classic: return { command, 0x00 } ;
-                        break ;
-                case ffb_protocol::logitech_hidpp:
-                        FFFB_F_ERR_S( "protocol::play_force", "protocol not implemented" ) ;
-                        return {} ;
-                default:
-                        FFFB_F_ERR_S( "protocol::play_force", "protocol not supported" ) ;
-                        return {} ;
-        }
-}
+        // reports that never change, built once at compile time
+        static constexpr report           stop_all { stop( FFFB_FORCE_SLOT_AUTOCENTER ) } ;
+        static constexpr report autocenter_all_off { disable_autocenter( FFFB_FORCE_SLOT_AUTOCENTER ) } ;
+        static constexpr report autocenter_all_on  {  enable_autocenter( FFFB_FORCE_SLOT_AUTOCENTER ) } ;
 
-constexpr vector< report > protocol::init_sequence ( ffb_protocol const protocol, uti::u32_t device_id ) noexcept
-{
-        vector< report > reports ;
+        // switch to native mode, then open up the full 900 degrees
+        static constexpr uti::array< report, 2 > native_mode_sequence
+        {
+                report{ 0x30, 0xf8, 0x09, 0x05, 0x01 },
+                set_range( 900 ),
+        } ;
 
-        if( protocol == ffb_protocol::logitech_classic )
+        static constexpr report_batch init_sequence ( uti::u32_t const device_id ) noexcept
         {
+                report_batch reports ;
+
                 switch( device_id )
                 {
                         case Logitech_G923_PS_DeviceID:
-                                reports.push_back( { 0x30, 0xf8, 0x09, 0x05, 0x01 } ) ;
-                                reports.push_back( set_range( protocol, 900 ) ) ;
-                                break ;
                         case Logitech_G29_PS4_DeviceID:
-                                reports.push_back( { 0x30, 0xf8, 0x09, 0x05, 0x01 } ) ;
-                                reports.push_back( set_range( protocol, 900 ) ) ;
+                                for( auto const & rep : native_mode_sequence ) reports.push_back( rep ) ;
                                 break ;
                         default:
-                                FFFB_F_ERR_S( "protocol::init_sequence", "unknown device id" ) ;
+                                FFFB_F_ERR_S( "logitech_classic::init_sequence", "unknown device id" ) ;
                 }
+                return reports ;
         }
-        return reports ;
-}
-
-constexpr report protocol::_constant_force ( ffb_protocol const protocol, force const & f ) noexcept
-{
-        uti::u8_t command   = f.params.slot << 4 ;
-        uti::u8_t amplitude = f.constant.amplitude ;
-
-        switch( protocol )
-        {
-                case ffb_protocol::logitech_classic : return { command, 0x00, amplitude, amplitude, amplitude, amplitude, 0x00 } ;
-                case ffb_protocol::logitech_hidpp :
-                        FFFB_F_ERR_S( "protocol::_constant_force", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::_constant_force", "protocol not supported" ) ;
-                        return {} ;
-        }
-}
 
-constexpr report protocol::_spring_force ( ffb_protocol const protocol, force const & f ) noexcept
-{
-        uti::u8_t command = f.params.slot << 4 ;
-
-        uti::u8_t dead_start   = f.spring.dead_start   ;
-        uti::u8_t dead_end     = f.spring.dead_end     ;
-        uti::u8_t slope_left   = f.spring.slope_left   & 0b0111 ;
-        uti::u8_t slope_right  = f.spring.slope_right  & 0b0111 ;
-        uti::u8_t invert_left  = f.spring.invert_left  & 0b0001 ;
-        uti::u8_t invert_right = f.spring.invert_right & 0b0001 ;
-        uti::u8_t amplitude    = f.spring.amplitude    ;
-
-        switch( protocol )
+        // how the writer schedules a report: refreshes coalesce per slot and rank by what they carry,
+        // leds are the first to go under load, everything else changes device state and goes out in order
+        static constexpr report_tag classify ( report const & rep ) noexcept
         {
-                case ffb_protocol::logitech_classic : return { command, 0x01,
-                                                               dead_start, dead_end,
-                                                               uti::u8_t( (  slope_right << 4 ) |  slope_left ),
-                                                               uti::u8_t( ( invert_right << 4 ) | invert_left ),
-                                                               amplitude } ;
-                case ffb_protocol::logitech_hidpp :
-                        FFFB_F_ERR_S( "protocol::_spring_force", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::_spring_force", "protocol not supported" ) ;
-                        return {} ;
-        }
+                uti::u8_t const command = rep.data[ 0 ] & 0x0F ;
+                uti::u8_t const slots   = rep.data[ 0 ] >> 4   ;
 
-}
-
-constexpr report protocol::_damper_force ( ffb_protocol const protocol, force const & f ) noexcept
-{
-        uti::u8_t command = f.params.slot << 4 ;
-
-        uti::u8_t slope_left   = f.damper.slope_left   & 0b0111 ;
-        uti::u8_t slope_right  = f.damper.slope_right  & 0b0111 ;
-        uti::u8_t invert_left  = f.damper.invert_left  & 0b0001 ;
-        uti::u8_t invert_right = f.damper.invert_right & 0b0001 ;
-
-        switch( protocol )
-        {
-                case ffb_protocol::logitech_classic : return { command, 0x02, slope_left, invert_left, slope_right, invert_right, 0x00 } ;
-                case ffb_protocol::logitech_hidpp :
-                        FFFB_F_ERR_S( "protocol::_damper_force", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::_damper_force", "protocol not supported" ) ;
-                        return {} ;
-        }
-
-}
-
-constexpr report protocol::_trapezoid_force ( ffb_protocol const protocol, force const & f ) noexcept
-{
-        uti::u8_t command = f.params.slot << 4 ;
+                if( rep.data[ 0 ] == 0xF8 )
+                {
+                        if( rep.data[ 1 ] == 0x12 ) return { report_priority::led, 0xF8, 0 } ;
 
-        uti::u8_t max_amp =   f.trapezoid.amplitude_max ;
-        uti::u8_t min_amp =   f.trapezoid.amplitude_min ;
-        uti::u8_t   t_max =   f.trapezoid.t_at_max ;
-        uti::u8_t   t_min =   f.trapezoid.t_at_min ;
-        uti::u8_t    dxdy = ( f.trapezoid.slope_step_x << 4 )
-                            | f.trapezoid.slope_step_y ;
+                        return { report_priority::control, 0, 0 } ;
+                }
+                if( command != 0x0C ) return { report_priority::control, 0, slots } ;
 
-        switch( protocol )
-        {
-                case ffb_protocol::logitech_classic : return { command, 0x06, max_amp, min_amp, t_max, t_min, dxdy } ;
-                case ffb_protocol::logitech_hidpp :
-                        FFFB_F_ERR_S( "protocol::_trapezoid_force", "protocol not implemented" ) ;
-                        return {} ;
-                default :
-                        FFFB_F_ERR_S( "protocol::_trapezoid_force", "protocol not supported" ) ;
-                        return {} ;
+                switch( slots )
+                {
+                        case FFFB_FORCE_SLOT_CONSTANT:  return { report_priority::constant , rep.data[ 0 ], slots } ;
+                        case FFFB_FORCE_SLOT_SPRING:
+                        case FFFB_FORCE_SLOT_DAMPER:    return { report_priority::condition, rep.data[ 0 ], slots } ;
+                        case FFFB_FORCE_SLOT_TRAPEZOID: return { report_priority::periodic , rep.data[ 0 ], slots } ;
+                        default:                        return { report_priority::control  ,             0, slots } ;
+                }
         }
-}
+} ;
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
 
 constexpr ffb_protocol get_supported_protocol ( hid_device const & device ) noexcept
 {
@@ -7,7 +7,11 @@
 #pragma once
 
 #include <fffb/hid/device.hxx>
+#include <fffb/hid/reader.hxx>
+#include <fffb/hid/writer.hxx>
+#include <fffb/joy/input.hxx>
 #include <fffb/joy/protocol.hxx>
+#include <fffb/util/clock.hxx>
 
 #define FFFB_WHEEL_USAGE_PAGE 0x01
 #define FFFB_WHEEL_USAGE      0x04
@@ -19,7 +23,24 @@ namespace fffb
 
 ////////////////////////////////////////////////////////////////////////////////
 
-class wheel
+enum class calibration_state : uti::u8_t
+{
+        idle       ,
+        pending    ,
+        turn_right ,
+        turn_left  ,
+        shake      ,
+        recenter   ,
+        done       ,
+        failed     ,
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a wheel bound to a single ffb protocol policy, see joy/protocol.hxx
+
+template< typename Protocol >
+class basic_wheel
 {
 public:
         static constexpr  constant_force_params default_const_f  { FFFB_FORCE_SLOT_CONSTANT , false, 128, {} } ;
@@ -27,24 +48,80 @@ public:
         static constexpr    damper_force_params default_damper_f { FFFB_FORCE_SLOT_DAMPER   , false,   0,   0, 0, 0, {} } ;
         static constexpr trapezoid_force_params default_trap_f   { FFFB_FORCE_SLOT_TRAPEZOID, false, 127, 128, 0, 0, 0, 0, {} } ;
 
-        constexpr wheel () noexcept ;
+        using protocol_type = Protocol ;
+
+        constexpr basic_wheel () noexcept = default ;
 
-        constexpr ~wheel () noexcept { if( device_ ){ stop_forces() ; enable_autocenter() ; } }
+        constexpr ~basic_wheel () noexcept { stop_input() ; stop_writer() ; if( device_ && !session_closed_ ){ stop_forces() ; enable_autocenter() ; close_session() ; } }
 
         [[ nodiscard ]] constexpr operator bool () const noexcept { return static_cast< bool >( device_ ) ; }
 
+        // finds the wheel on first use and keeps it, later calls only reopen the session
+        constexpr bool connect () noexcept ;
+
+        // hotplug handling, both must run on the thread producing reports.
+        // offline drops the device handle and stops emitting reports,
+        // reconnect rediscovers the wheel, replays the init sequence and lets the next refresh redownload every effect
+        constexpr void mark_offline () noexcept ;
+        constexpr bool    reconnect () noexcept ;
+
+        [[ nodiscard ]] constexpr bool online () const noexcept { return !offline_.load( std::memory_order_acquire ) ; }
+
+        // a write failed or the writer dropped a report, the next refresh will redownload every effect
+        [[ nodiscard ]] constexpr bool resync_pending () const noexcept
+        {
+                return resync_.load( std::memory_order_acquire ) || writer_.dropped() != seen_dropped_ ;
+        }
+
+        // a write failed and the session can't be trusted anymore, reports are suspended until reconnect().
+        // the writer thread only flags it, reopening is left to the thread producing reports
+        [[ nodiscard ]] constexpr bool session_lost () const noexcept { return lost_.load( std::memory_order_acquire ) ; }
+
+        // a closed session stays closed, synchronous writes only open one that was never opened
+        constexpr bool  open_session () noexcept ;
+        constexpr void close_session () noexcept ;
+
+        [[ nodiscard ]] constexpr bool session_open () const noexcept { return session_open_ ; }
+
+        constexpr bool start_writer () noexcept ;
+        constexpr void  stop_writer () noexcept ;
+
+        [[ nodiscard ]] constexpr report_writer const & writer () const noexcept { return writer_ ; }
+
+        // input reports are parsed on the reader's own thread, input() is a lock-free snapshot of the latest one
+        constexpr bool start_input () noexcept ;
+        constexpr void  stop_input () noexcept ;
+
+        [[ nodiscard ]] constexpr bool input_running () const noexcept { return reader_.running() ; }
+
+        [[ nodiscard ]] constexpr wheel_input input () const noexcept { return input_.latest() ; }
+
+        // 0 until the wheel sent its first input report
+        [[ nodiscard ]] constexpr uti::u64_t input_generation () const noexcept { return input_.generation() ; }
+
         constexpr bool calibrate () noexcept ;
 
-        constexpr bool disable_autocenter () const noexcept ;
-        constexpr bool  enable_autocenter () const noexcept ;
+        // calibration as a time-stepped state machine, begin_calibration() only arms it,
+        // step_calibration() does the report writes once the current stage's deadline has passed
+        constexpr void begin_calibration () noexcept ;
+
+        constexpr calibration_state step_calibration ( nanoseconds_t _now_ ) noexcept ;
+
+        [[ nodiscard ]] constexpr calibration_state calibration () const noexcept { return calibration_ ; }
 
-        constexpr bool download_forces () const noexcept ;
-        constexpr bool  refresh_forces ()       noexcept ;
+        [[ nodiscard ]] constexpr bool calibrating () const noexcept
+        { return calibration_ != calibration_state::idle && calibration_ != calibration_state::done && calibration_ != calibration_state::failed ; }
+
+        constexpr bool disable_autocenter () noexcept ;
+        constexpr bool  enable_autocenter () noexcept ;
+
+        constexpr bool download_forces () noexcept ;
+        constexpr bool  refresh_forces () noexcept ;
 
         constexpr bool play_forces () noexcept ;
         constexpr bool stop_forces () noexcept ;
 
-        constexpr bool set_led_pattern ( uti::u8_t _pattern_ ) const noexcept ;
+        constexpr bool set_led_pattern ( uti::u8_t _pattern_ ) noexcept ;
 
         constexpr void q_disable_autocenter () noexcept ;
         constexpr void  q_enable_autocenter () noexcept ;
@@ -72,414 +149,811 @@ public:
 
         [[ nodiscard ]] constexpr trapezoid_force_params       & trapezoid_force ()       noexcept { return trapezoid_ ; }
         [[ nodiscard ]] constexpr trapezoid_force_params const & trapezoid_force () const noexcept { return trapezoid_ ; }
+#ifdef FFFB_RECORDER
+        // every report handed to the device since the last clear_tap(), for the recorder
+        [[ nodiscard ]] constexpr report_batch const & tapped () const noexcept { return tap_ ; }
+
+        constexpr void clear_tap () noexcept { tap_.clear() ; }
+#endif // FFFB_RECORDER
 private:
-        hid_device     device_ ;
-        ffb_protocol protocol_ ;
+        hid_device device_ ;
 
         constant_force_params   constant_ { default_const_f  } ;
         spring_force_params       spring_ { default_spring_f } ;
         damper_force_params       damper_ { default_damper_f } ;
         trapezoid_force_params trapezoid_ { default_trap_f   } ;
 
-        bool playing_ { false } ;
+        struct slot_cache
+        {
+                report last_sent {} ;
+                bool       valid { false } ;
+                bool     playing { false } ;
+        } ;
+        enum class autocenter_state
+        {
+                unknown ,
+                on      ,
+                off     ,
+        } ;
+        static constexpr uti::ssize_t slot_count { static_cast< uti::ssize_t >( force_type::COUNT ) } ;
+
+        slot_cache       slots_ [ slot_count ] {} ;
+        uti::i16_t       led_pattern_ { -1 } ;
+        autocenter_state autocenter_  { autocenter_state::unknown } ;
+
+        std::atomic< bool >  resync_ { false } ;
+        std::atomic< bool > offline_ { false } ;
+        std::atomic< bool >    lost_ { false } ;
+
+        bool resume_writer_ { false } ;
+        bool resume_input_  { false } ;
+
+        // writer drops already accounted for, any new one means a report the device never saw
+        uti::u64_t seen_dropped_ { 0 } ;
+
+        bool session_open_   { false } ;
+        bool session_closed_ { false } ;
+
+        static constexpr nanoseconds_t calibration_turn_right_ns { 750 * 1000 * 1000 } ;
+        static constexpr nanoseconds_t calibration_turn_left_ns  { ns_per_sec        } ;
+        static constexpr nanoseconds_t calibration_shake_ns      { ns_per_sec        } ;
+        static constexpr nanoseconds_t calibration_recenter_ns   { 750 * 1000 * 1000 } ;
+
+        calibration_state calibration_          { calibration_state::idle } ;
+        nanoseconds_t     calibration_deadline_ {                       0 } ;
+
+        report_batch reports_ {} ;
+
+        report_writer writer_ ;
 
-        vector< report > reports_ {} ;
+        hid_reader          reader_ ;
+        wheel_input_tracker  input_ ;
+#ifdef FFFB_RECORDER
+        report_batch tap_ {} ;
 
-        constexpr bool _write_report (          report   const & report , char const * scope ) const noexcept ;
-        constexpr bool _write_reports ( vector< report > const & reports, char const * scope ) const noexcept ;
+        constexpr void _tap ( report const & report ) noexcept { if( !tap_.full() ) tap_.push_back( report ) ; }
+#endif // FFFB_RECORDER
 
-        constexpr bool _init_protocol () const noexcept ;
+        constexpr bool _write_report (          report   const & report , char const * scope ) noexcept ;
+        constexpr bool _write_reports ( report_batch const & reports, char const * scope ) noexcept ;
+
+        constexpr bool _send_report  (          report   const & report , char const * scope ) noexcept ;
+        constexpr bool _send_reports ( report_batch const & reports, char const * scope ) noexcept ;
+
+        constexpr bool _write_device ( report const & report, char const * scope ) noexcept ;
+
+        static constexpr bool _writer_sink ( void * context, report const & report ) noexcept ;
+
+        // calls fn( slot cache, effect params ) once per slot, each with its concrete params type
+        template< typename Fn >
+        constexpr void _for_each_slot ( Fn && fn ) noexcept ;
+
+        constexpr void _append ( report_batch & reports, report const & report ) noexcept ;
+
+        constexpr void _collect_downloads ( report_batch & reports ) noexcept ;
+        constexpr void _collect_play      ( report_batch & reports ) noexcept ;
+        constexpr void _collect_refresh   ( report_batch & reports ) noexcept ;
+
+        constexpr void _invalidate_cache () noexcept ;
+        constexpr void _check_resync     () noexcept ;
+
+        constexpr void _release_session () noexcept ;
+
+        constexpr bool _init_protocol () noexcept ;
 } ;
 
+using wheel = basic_wheel< logitech_classic > ;
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr wheel::wheel () noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::connect () noexcept
 {
-        vector< hid_device > devices = list_hid_devices() ;
-
-        for( auto & device : devices )
+        if( !device_ )
         {
-                if( device.usage     () != FFFB_WHEEL_USAGE ||
-                    device.usage_page() != FFFB_WHEEL_USAGE_PAGE )
-                {
-                        FFFB_F_DBG_S( "wheel::ctor", "skipping device 0x%.8x due to bad usage" ) ;
-                        continue ;
-                }
-                for( auto const & known_wheel : known_wheel_device_ids )
+                vector< hid_device > devices = find_hid_devices( FFFB_WHEEL_USAGE_PAGE, FFFB_WHEEL_USAGE, Logitech_VendorID ) ;
+
+                for( auto & device : devices )
                 {
-                        if( device.device_id () == known_wheel
-                         && device.usage_page() == FFFB_WHEEL_USAGE_PAGE
-                         && device.usage     () == FFFB_WHEEL_USAGE )
+                        for( auto const & known_wheel : known_wheel_device_ids )
                         {
-                                FFFB_F_INFO_S( "wheel::ctor", "using wheel with device id 0x%.8x", device.device_id() ) ;
-                                device_ = UTI_MOVE( device ) ;
-                                protocol_ = get_supported_protocol( device_ ) ;
+                                if( device.device_id() == known_wheel )
+                                {
+                                        FFFB_F_INFO_S( "wheel::connect", "using wheel with device id 0x%.8x", device.device_id() ) ;
+                                        device_ = UTI_MOVE( device ) ;
+                                        break ;
+                                }
                         }
+                        if( device_ ) break ;
                 }
-                if( device.vendor_id() == Logitech_VendorID )
+                if( !device_ && !devices.empty() )
                 {
-                        FFFB_F_WARN_S( "wheel::ctor", "using unknown logitech wheel with device id 0x%.8x", device.device_id() ) ;
-                        device_ = UTI_MOVE( device ) ;
-                        protocol_ = get_supported_protocol( device_ ) ;
+                        FFFB_F_WARN_S( "wheel::connect", "using unknown logitech wheel with device id 0x%.8x", devices.front().device_id() ) ;
+                        device_ = UTI_MOVE( devices.front() ) ;
+                }
+                if( !device_ )
+                {
+                        FFFB_F_ERR_S( "wheel::connect", "no known wheels found!" ) ;
+                        return false ;
+                }
+                // the one runtime protocol decision, everything past this point is fixed by the template argument
+                if( get_supported_protocol( device_ ) != Protocol::id )
+                {
+                        FFFB_F_ERR_S( "wheel::connect", "device 0x%.8x doesn't speak this wheel's protocol", device_.device_id() ) ;
+                        device_ = {} ;
+                        return false ;
                 }
         }
-        if( device_ )
-        {
-                _init_protocol() ;
-        }
-        else
-        {
-                FFFB_F_ERR_S( "wheel::ctor", "no known wheels found!" ) ;
-        }
+        if( !open_session() ) return false ;
+
+        return _init_protocol() ;
 }
 
-////////////////////////////////////////////////////////////////////////////////
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::mark_offline () noexcept
+{
+        if( offline_.exchange( true, std::memory_order_acq_rel ) ) return ;
 
-constexpr bool wheel::calibrate () noexcept
+        FFFB_F_WARN_S( "wheel::mark_offline", "wheel went offline, suspending reports" ) ;
+
+        // whatever is still queued is dropped by the sink, the handle may only go away once the writer is idle
+        resume_writer_ = writer_.running() ;
+        stop_writer() ;
+
+        resume_input_ = reader_.running() || resume_input_ ;
+        stop_input() ;
+
+        reports_.clear() ;
+        _invalidate_cache() ;
+
+        session_open_ = false ;
+        device_       = {}    ;
+}
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::reconnect () noexcept
 {
-        if( !device_ )
-        {
-                return false ;
-        }
-        if( !disable_autocenter() )
+        resume_writer_ = writer_.running() || resume_writer_ ;
+        resume_input_  = reader_.running() || resume_input_  ;
+
+        stop_writer() ;
+        stop_input () ;
+
+        // nothing else touches the device now
+        lost_.store( false, std::memory_order_release ) ;
+
+        if( session_open_ ) _release_session() ;
+
+        device_ = {} ;
+        _invalidate_cache() ;
+
+        // the init sequence goes through the online gate, writer and reader stay stopped until it's through
+        offline_.store( false, std::memory_order_release ) ;
+
+        if( !connect() )
         {
+                offline_.store( true, std::memory_order_release ) ;
+
+                if( session_open_ ) _release_session() ;
+                device_ = {} ;
+
                 return false ;
         }
-        if( !stop_forces() )
+        disable_autocenter() ;
+
+        if( resume_writer_ ) start_writer() ;
+        resume_writer_ = false ;
+
+        if( resume_input_ ) start_input() ;
+        resume_input_ = false ;
+
+        FFFB_F_INFO_S( "wheel::reconnect", "wheel back online with device id 0x%.8x", device_.device_id() ) ;
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::open_session () noexcept
+{
+        if( session_open_ ) return true ;
+
+        if( !device_.open() )
         {
+                FFFB_F_ERR_S( "wheel::open_session", "failed opening device %x", device_.device_id() ) ;
                 return false ;
         }
+        FFFB_F_DBG_S( "wheel::open_session", "opened session for device %x", device_.device_id() ) ;
+        session_open_   = true  ;
+        session_closed_ = false ;
+        return true ;
+}
 
-        // turn right
-        {
-                constant_.  enabled = true ;
-                constant_.amplitude =   96 ;
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::close_session () noexcept
+{
+        _release_session() ;
+        session_closed_ = true ;
+}
 
-                download_forces() ;
-                play_forces() ;
-                FFFB_DBG_S( "wheel::calibrate", "turning right..." ) ;
-                usleep( 750 * 1000 ) ;
-        }
-        // turn left
-        {
-                constant_.amplitude = 160 ;
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::_release_session () noexcept
+{
+        if( !session_open_ ) return ;
 
-                refresh_forces() ;
-                FFFB_DBG_S( "wheel::calibrate", "turning left..." ) ;
-                usleep( 1000 * 1000 ) ;
-        }
-        // shake it
-        {
-                stop_forces() ;
-                constant_.enabled = false ;
-
-                trapezoid_.      enabled = true ;
-                trapezoid_.amplitude_max =   96 ;
-                trapezoid_.amplitude_min =  160 ;
-                trapezoid_.     t_at_max =   32 ;
-                trapezoid_.     t_at_min =   32 ;
-                trapezoid_. slope_step_x =    6 ;
-                trapezoid_. slope_step_y =    6 ;
-
-                download_forces() ;
-                play_forces() ;
-                FFFB_DBG_S( "wheel::calibrate", "shaking it..." ) ;
-                usleep( 1000 * 1000 ) ;
-                stop_forces() ;
-                trapezoid_.enabled = false ;
-        }
-        // return to center
-        {
-                stop_forces() ;
-                enable_autocenter() ;
-                FFFB_DBG_S( "wheel::calibrate", "recentering..." ) ;
-                usleep( 750 * 1000 ) ;
-                disable_autocenter() ;
-        }
-        if( !stop_forces() )
+        if( !device_.close() )
         {
-                return false ;
+                FFFB_F_ERR_S( "wheel::close_session", "failed closing device %x", device_.device_id() ) ;
         }
-        return true ;
+        FFFB_F_DBG_S( "wheel::close_session", "closed session for device %x", device_.device_id() ) ;
+        session_open_ = false ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::disable_autocenter () const noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::start_writer () noexcept
 {
-        return _write_report( protocol::disable_autocenter( protocol_, 0x0F ), "wheel::disable_autocenter" ) ;
+        if( !device_ ) return false ;
+
+        return writer_.start( _writer_sink, Protocol::classify, this ) ;
 }
 
-constexpr bool wheel::enable_autocenter () const noexcept
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::stop_writer () noexcept
 {
-        return _write_report( protocol::enable_autocenter( protocol_, 0x0F ), "wheel::enable_autocenter" ) ;
+        if( !writer_.running() ) return ;
+
+        writer_.stop() ;
+        writer_.log_stats( "wheel::stop_writer" ) ;
 }
 
-constexpr void wheel::q_disable_autocenter () noexcept
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::start_input () noexcept
 {
-        reports_.emplace_back( protocol::disable_autocenter( protocol_, 0x0F ) ) ;
+        if( !device_ || !session_open_ ) return false ;
+
+        if( reader_.running() ) return true ;
+
+        input_.reset() ;
+
+        return reader_.start( device_, wheel_input_tracker::on_report, &input_ ) ;
 }
 
-constexpr void wheel::q_enable_autocenter () noexcept
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::stop_input () noexcept
 {
-        reports_.emplace_back( protocol::enable_autocenter( protocol_, 0x0F ) ) ;
+        reader_.stop() ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::download_forces () const noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::calibrate () noexcept
 {
-        force f_const  { force_type::CONSTANT , {} } ;
-        force f_spring { force_type::SPRING   , {} } ;
-        force f_damper { force_type::DAMPER   , {} } ;
-        force f_trap   { force_type::TRAPEZOID, {} } ;
-
-        f_const .constant  = constant_   ;
-        f_spring.spring    = spring_     ;
-        f_damper.damper    = damper_     ;
-        f_trap  .trapezoid = trapezoid_  ;
+        begin_calibration() ;
 
-        vector< report > reports( 5 ) ;
+        calibration_state state = step_calibration( monotonic_now() ) ;
 
-        if( f_const.params.enabled )
-        {
-                reports.emplace_back( protocol::download_force( protocol_, f_const ) ) ;
-        }
-        if( f_spring.params.enabled )
+        while( calibrating() )
         {
-                reports.emplace_back( protocol::download_force( protocol_, f_spring ) ) ;
+                sleep_until( calibration_deadline_ ) ;
+                state = step_calibration( monotonic_now() ) ;
         }
-        if( f_damper.params.enabled )
-        {
-                reports.emplace_back( protocol::download_force( protocol_, f_damper ) ) ;
-        }
-        if( f_trap.params.enabled )
+        return state == calibration_state::done ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::begin_calibration () noexcept
+{
+        calibration_ = device_ ? calibration_state::pending : calibration_state::failed ;
+}
+
+template< typename Protocol >
+constexpr calibration_state basic_wheel< Protocol >::step_calibration ( nanoseconds_t const _now_ ) noexcept
+{
+        if( !calibrating() ) return calibration_ ;
+
+        if( calibration_ != calibration_state::pending && _now_ < calibration_deadline_ ) return calibration_ ;
+
+        switch( calibration_ )
         {
-                reports.emplace_back( protocol::download_force( protocol_, f_trap ) ) ;
+                case calibration_state::pending:
+                {
+                        if( !disable_autocenter() || !stop_forces() )
+                        {
+                                calibration_ = calibration_state::failed ;
+                                break ;
+                        }
+                        constant_.  enabled = true ;
+                        constant_.amplitude =   96 ;
+
+                        download_forces() ;
+                        play_forces() ;
+                        FFFB_DBG_S( "wheel::calibrate", "turning right..." ) ;
+
+                        calibration_          = calibration_state::turn_right ;
+                        calibration_deadline_ = _now_ + calibration_turn_right_ns ;
+                        break ;
+                }
+                case calibration_state::turn_right:
+                {
+                        constant_.amplitude = 160 ;
+
+                        refresh_forces() ;
+                        FFFB_DBG_S( "wheel::calibrate", "turning left..." ) ;
+
+                        calibration_          = calibration_state::turn_left ;
+                        calibration_deadline_ = _now_ + calibration_turn_left_ns ;
+                        break ;
+                }
+                case calibration_state::turn_left:
+                {
+                        stop_forces() ;
+                        constant_.enabled = false ;
+
+                        trapezoid_.      enabled = true ;
+                        trapezoid_.amplitude_max =   96 ;
+                        trapezoid_.amplitude_min =  160 ;
+                        trapezoid_.     t_at_max =   32 ;
+                        trapezoid_.     t_at_min =   32 ;
+                        trapezoid_. slope_step_x =    6 ;
+                        trapezoid_. slope_step_y =    6 ;
+
+                        download_forces() ;
+                        play_forces() ;
+                        FFFB_DBG_S( "wheel::calibrate", "shaking it..." ) ;
+
+                        calibration_          = calibration_state::shake ;
+                        calibration_deadline_ = _now_ + calibration_shake_ns ;
+                        break ;
+                }
+                case calibration_state::shake:
+                {
+                        stop_forces() ;
+                        trapezoid_.enabled = false ;
+
+                        enable_autocenter() ;
+                        FFFB_DBG_S( "wheel::calibrate", "recentering..." ) ;
+
+                        calibration_          = calibration_state::recenter ;
+                        calibration_deadline_ = _now_ + calibration_recenter_ns ;
+                        break ;
+                }
+                case calibration_state::recenter:
+                {
+                        disable_autocenter() ;
+
+                        calibration_ = stop_forces() ? calibration_state::done : calibration_state::failed ;
+                        break ;
+                }
+                default:
+                        break ;
         }
+        return calibration_ ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::disable_autocenter () noexcept
+{
+        _check_resync() ;
+
+        if( autocenter_ == autocenter_state::off ) return true ;
+
+        bool const ok = _write_report( Protocol::autocenter_all_off, "wheel::disable_autocenter" ) ;
+
+        autocenter_ = ok ? autocenter_state::off : autocenter_state::unknown ;
+        return ok ;
+}
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::enable_autocenter () noexcept
+{
+        _check_resync() ;
+
+        if( autocenter_ == autocenter_state::on ) return true ;
+
+        bool const ok = _write_report( Protocol::autocenter_all_on, "wheel::enable_autocenter" ) ;
+
+        autocenter_ = ok ? autocenter_state::on : autocenter_state::unknown ;
+        return ok ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::q_disable_autocenter () noexcept
+{
+        _check_resync() ;
+
+        if( autocenter_ == autocenter_state::off ) return ;
+
+        _append( reports_, Protocol::autocenter_all_off ) ;
+        autocenter_ = autocenter_state::off ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::q_enable_autocenter () noexcept
+{
+        _check_resync() ;
+
+        if( autocenter_ == autocenter_state::on ) return ;
+
+        _append( reports_, Protocol::autocenter_all_on ) ;
+        autocenter_ = autocenter_state::on ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::download_forces () noexcept
+{
+        report_batch reports ;
+
+        _collect_downloads( reports ) ;
+
         return _write_reports( reports, "wheel::download_forces" ) ;
 }
 
-constexpr void wheel::q_download_forces () noexcept
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::q_download_forces () noexcept
 {
-        force f_const  { force_type::CONSTANT , {} } ;
-        force f_spring { force_type::SPRING   , {} } ;
-        force f_damper { force_type::DAMPER   , {} } ;
-        force f_trap   { force_type::TRAPEZOID, {} } ;
+        _collect_downloads( reports_ ) ;
+}
 
-        f_const .constant  = constant_   ;
-        f_spring.spring    = spring_     ;
-        f_damper.damper    = damper_     ;
-        f_trap  .trapezoid = trapezoid_  ;
+////////////////////////////////////////////////////////////////////////////////
 
-        if( f_const.params.enabled )
-        {
-                reports_.emplace_back( protocol::download_force( protocol_, f_const ) ) ;
-        }
-        if( f_spring.params.enabled )
-        {
-                reports_.emplace_back( protocol::download_force( protocol_, f_spring ) ) ;
-        }
-        if( f_damper.params.enabled )
-        {
-                reports_.emplace_back( protocol::download_force( protocol_, f_damper ) ) ;
-        }
-        if( f_trap.params.enabled )
-        {
-                reports_.emplace_back( protocol::download_force( protocol_, f_trap ) ) ;
-        }
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::play_forces () noexcept
+{
+        report_batch reports ;
+
+        _collect_play( reports ) ;
+
+        return _write_reports( reports, "wheel::play_forces" ) ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::q_play_forces () noexcept
+{
+        _collect_play( reports_ ) ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::play_forces () noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::stop_forces () noexcept
 {
-        playing_ = true ;
+        for( auto & slot : slots_ ) slot = {} ;
 
-        uti::u8_t slots { 0 } ;
+        return _write_report( Protocol::stop_all, "wheel::stop_forces" ) ;
+}
 
-        if( constant_ .enabled ) slots |= constant_ .slot ;
-        if( spring_   .enabled ) slots |= spring_   .slot ;
-        if( damper_   .enabled ) slots |= damper_   .slot ;
-        if( trapezoid_.enabled ) slots |= trapezoid_.slot ;
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::q_stop_forces () noexcept
+{
+        for( auto & slot : slots_ ) slot = {} ;
 
-        return _write_report( protocol::play_force( protocol_, slots ), "wheel::play_forces" ) ;
+        _append( reports_, Protocol::stop_all ) ;
 }
 
-constexpr void wheel::q_play_forces () noexcept
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::refresh_forces () noexcept
 {
-        playing_ = true ;
+        report_batch reports ;
 
-        uti::u8_t slots { 0 } ;
+        _collect_refresh( reports ) ;
 
-        if( constant_ .enabled ) slots |= constant_ .slot ;
-        if( spring_   .enabled ) slots |= spring_   .slot ;
-        if( damper_   .enabled ) slots |= damper_   .slot ;
-        if( trapezoid_.enabled ) slots |= trapezoid_.slot ;
+        if( reports.empty() ) return true ;
 
-        reports_.emplace_back( protocol::play_force( protocol_, slots ) ) ;
+        return _write_reports( reports, "wheel::refresh_forces" ) ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::q_refresh_forces () noexcept
+{
+        _collect_refresh( reports_ ) ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::stop_forces () noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::set_led_pattern ( uti::u8_t pattern ) noexcept
 {
-        playing_ = false ;
+        _check_resync() ;
+
+        pattern &= 0b00011111 ;
+
+        if( led_pattern_ == pattern ) return true ;
 
-        return _write_report( protocol::stop_force( protocol_, 0x0F ), "wheel::stop_forces" ) ;
+        bool const ok = _write_report( Protocol::set_led_pattern( pattern ), "wheel::set_led_pattern" ) ;
+
+        led_pattern_ = ok ? pattern : -1 ;
+        return ok ;
 }
 
-constexpr void wheel::q_stop_forces () noexcept
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::q_set_led_pattern ( uti::u8_t pattern ) noexcept
 {
-        playing_ = false ;
+        _check_resync() ;
+
+        pattern &= 0b00011111 ;
 
-        reports_.emplace_back( protocol::stop_force( protocol_, 0x0F ) ) ;
+        if( led_pattern_ == pattern ) return ;
+
+        _append( reports_, Protocol::set_led_pattern( pattern ) ) ;
+        led_pattern_ = pattern ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::refresh_forces () noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::flush_reports () noexcept
 {
-        if( !playing_ ) return play_forces() ;
+        if( reports_.empty() ) return true ;
+
+        auto res = _write_reports( reports_, "wheel::flush" ) ;
+        reports_.clear() ;
 
-        force f_const  { force_type::CONSTANT , {} } ;
-        force f_spring { force_type::SPRING   , {} } ;
-        force f_damper { force_type::DAMPER   , {} } ;
-        force f_trap   { force_type::TRAPEZOID, {} } ;
+        return res ;
+}
 
-        f_const.constant =  constant_ ;
-        f_spring. spring =    spring_ ;
-        f_damper. damper =    damper_ ;
-        f_trap.trapezoid = trapezoid_ ;
+////////////////////////////////////////////////////////////////////////////////
 
-        vector< report > reports( 4 ) ;
+template< typename Protocol >
+template< typename Fn >
+constexpr void basic_wheel< Protocol >::_for_each_slot ( Fn && fn ) noexcept
+{
+        static_assert( slot_count == 4, "fffb::wheel: _for_each_slot must visit every slot" ) ;
 
-        if( f_const.params.enabled )
-        {
-                reports.emplace_back( protocol::refresh_force( protocol_, f_const ) ) ;
-        }
-        if( f_spring.params.enabled )
-        {
-                reports.emplace_back( protocol::refresh_force( protocol_, f_spring ) ) ;
-        }
-        if( f_damper.params.enabled )
+        fn( slots_[ static_cast< uti::ssize_t >( force_type:: CONSTANT ) ], constant_  ) ;
+        fn( slots_[ static_cast< uti::ssize_t >( force_type::   SPRING ) ], spring_    ) ;
+        fn( slots_[ static_cast< uti::ssize_t >( force_type::   DAMPER ) ], damper_    ) ;
+        fn( slots_[ static_cast< uti::ssize_t >( force_type::TRAPEZOID ) ], trapezoid_ ) ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::_append ( report_batch & reports, report const & report ) noexcept
+{
+        if( reports.full() )
         {
-                reports.emplace_back( protocol::refresh_force( protocol_, f_damper ) ) ;
+                FFFB_F_ERR_S( "wheel::append", "report batch full, dropping report" ) ;
+                return ;
         }
-        if( f_trap.params.enabled )
+        reports.push_back( report ) ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::_collect_downloads ( report_batch & reports ) noexcept
+{
+        _check_resync() ;
+
+        _for_each_slot( [ & ]( slot_cache & slot, auto const & params )
         {
-                reports.emplace_back( protocol::refresh_force( protocol_, f_trap ) ) ;
-        }
-        return _write_reports( reports, "wheel::refresh_forces" ) ;
+                if( !params.enabled ) return ;
+
+                _append( reports, Protocol::download( params ) ) ;
+
+                slot.last_sent = Protocol::refresh( params ) ;
+                slot.    valid = true ;
+        } ) ;
 }
 
-constexpr void wheel::q_refresh_forces () noexcept
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::_collect_play ( report_batch & reports ) noexcept
 {
-        if( !playing_ ) q_play_forces() ;
+        uti::u8_t mask { 0 } ;
 
-        force f_const  { force_type::CONSTANT , {} } ;
-        force f_spring { force_type::SPRING   , {} } ;
-        force f_damper { force_type::DAMPER   , {} } ;
-        force f_trap   { force_type::TRAPEZOID, {} } ;
+        _for_each_slot( [ & ]( slot_cache & slot, auto const & params )
+        {
+                if( !params.enabled ) return ;
+
+                mask |= params.slot ;
+                slot.playing = true ;
+        } ) ;
+        _append( reports, Protocol::play( mask ) ) ;
+}
+
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::_collect_refresh ( report_batch & reports ) noexcept
+{
+        _check_resync() ;
 
-        f_const.constant =  constant_ ;
-        f_spring. spring =    spring_ ;
-        f_damper. damper =    damper_ ;
-        f_trap.trapezoid = trapezoid_ ;
+        // slots that got disabled since the last tick are stopped first,
+        // in the classic protocol slot masks overlap so everything sharing a bit with the stop is forgotten too
+        uti::u8_t stop_mask { 0 } ;
 
-        if( f_const.params.enabled )
+        _for_each_slot( [ & ]( slot_cache & slot, auto const & params )
         {
-                reports_.emplace_back( protocol::refresh_force( protocol_, f_const ) ) ;
-        }
-        if( f_spring.params.enabled )
+                if( !params.enabled && slot.playing ) stop_mask |= params.slot ;
+        } ) ;
+        if( stop_mask )
         {
-                reports_.emplace_back( protocol::refresh_force( protocol_, f_spring ) ) ;
+                _append( reports, Protocol::stop( stop_mask ) ) ;
+
+                _for_each_slot( [ & ]( slot_cache & slot, auto const & params )
+                {
+                        if( params.slot & stop_mask ) slot = {} ;
+                } ) ;
         }
-        if( f_damper.params.enabled )
+        // stopped slots get downloaded and played, playing slots only get refreshed when their report changed
+        uti::u8_t play_mask { 0 } ;
+
+        _for_each_slot( [ & ]( slot_cache & slot, auto const & params )
         {
-                reports_.emplace_back( protocol::refresh_force( protocol_, f_damper ) ) ;
-        }
-        if( f_trap.params.enabled )
+                if( !params.enabled ) return ;
+
+                report const rep = Protocol::refresh( params ) ;
+
+                if( !slot.playing )
+                {
+                        _append( reports, Protocol::download( params ) ) ;
+                        play_mask |= params.slot ;
+                }
+                else if( slot.valid && slot.last_sent == rep )
+                {
+                        return ;
+                }
+                else
+                {
+                        _append( reports, rep ) ;
+                }
+                slot.last_sent = rep  ;
+                slot.    valid = true ;
+        } ) ;
+        if( play_mask )
         {
-                reports_.emplace_back( protocol::refresh_force( protocol_, f_trap ) ) ;
+                _append( reports, Protocol::play( play_mask ) ) ;
+
+                _for_each_slot( [ & ]( slot_cache & slot, auto const & params )
+                {
+                        if( params.enabled && ( params.slot & play_mask ) ) slot.playing = true ;
+                } ) ;
         }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::set_led_pattern ( uti::u8_t pattern ) const noexcept
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::_invalidate_cache () noexcept
 {
-        return _write_report( protocol::set_led_pattern( protocol_, pattern ), "wheel::set_led_pattern" ) ;
+        for( auto & slot : slots_ ) slot = {} ;
+
+        led_pattern_ = -1 ;
+        autocenter_  = autocenter_state::unknown ;
 }
 
-constexpr void wheel::q_set_led_pattern ( uti::u8_t pattern ) noexcept
+template< typename Protocol >
+constexpr void basic_wheel< Protocol >::_check_resync () noexcept
 {
-        reports_.emplace_back( protocol::set_led_pattern( protocol_, pattern ) ) ;
+        if( resync_.exchange( false, std::memory_order_acq_rel ) )
+        {
+                FFFB_F_DBG_S( "wheel::resync", "device state unknown, invalidating report cache" ) ;
+                _invalidate_cache() ;
+        }
+        if( uti::u64_t const dropped = writer_.dropped() ; dropped != seen_dropped_ )
+        {
+                FFFB_F_DBG_S( "wheel::resync", "writer dropped reports, invalidating report cache" ) ;
+                seen_dropped_ = dropped ;
+                _invalidate_cache() ;
+        }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::flush_reports () noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::_write_report ( report const & report, char const * scope ) noexcept
 {
-        auto res = _write_reports( reports_, "wheel::flush" ) ;
-        reports_.clear() ;
+        if( !online() || session_lost() ) return false ;
+#ifdef FFFB_RECORDER
+        _tap( report ) ;
+#endif // FFFB_RECORDER
 
-        return res ;
+        if( writer_.running() )
+        {
+                if( writer_.publish( report ) ) return true ;
+
+                FFFB_F_WARN_S( scope, "writer queue full, report dropped" ) ;
+                return false ;
+        }
+        return _send_report( report, scope ) ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::_write_report ( report const & report, [[ maybe_unused ]] char const * scope ) const noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::_write_reports ( report_batch const & reports, char const * scope ) noexcept
 {
-        if( !device_.open() )
-        {
-                FFFB_F_ERR_S( scope, "failed opening device %x", device_.device_id() ) ;
-                return false ;
-        }
-        if( !device_.write( report ) )
+        if( !online() || session_lost() ) return false ;
+#ifdef FFFB_RECORDER
+        for( auto const & report : reports ) _tap( report ) ;
+#endif // FFFB_RECORDER
+
+        if( writer_.running() )
         {
-                FFFB_F_ERR_S( scope, "failed sending report to device %x", device_.device_id() ) ;
+                if( writer_.publish( reports.data(), reports.size() ) ) return true ;
+
+                FFFB_F_WARN_S( scope, "writer queue full, reports dropped" ) ;
                 return false ;
         }
-        if( !device_.close() )
+        return _send_reports( reports, scope ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::_send_report ( report const & report, char const * scope ) noexcept
+{
+        if( !session_open_ && ( session_closed_ || !open_session() ) )
         {
-                FFFB_F_ERR_S( scope, "failed closing device %x", device_.device_id() ) ;
+                FFFB_F_ERR_S( scope, "no open session for device %x", device_.device_id() ) ;
                 return false ;
         }
-        return true ;
+        return _write_device( report, scope ) ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::_write_reports ( vector< report > const & reports, [[ maybe_unused ]] char const * scope ) const noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::_send_reports ( report_batch const & reports, char const * scope ) noexcept
 {
-        if( !device_.open() )
+        if( !session_open_ && ( session_closed_ || !open_session() ) )
         {
-                FFFB_F_ERR_S( scope, "failed opening device %x", device_.device_id() ) ;
+                FFFB_F_ERR_S( scope, "no open session for device %x", device_.device_id() ) ;
                 return false ;
         }
         for( auto const & rep : reports )
         {
-                if( !device_.write( rep ) )
+                if( !_write_device( rep, scope ) )
                 {
-                        FFFB_F_ERR_S( scope, "failed sending report to device %x", device_.device_id() ) ;
                         return false ;
                 }
         }
-        if( !device_.close() )
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::_write_device ( report const & report, [[ maybe_unused ]] char const * scope ) noexcept
+{
+        if( device_.write( report ) ) return true ;
+
+        // whatever we cached about the device is no longer trustworthy
+        resync_.store( true, std::memory_order_release ) ;
+
+        // may run on the writer thread, which shares the device with the reader.
+        // the session is only flagged here and reopened by reconnect() once both are stopped
+        if( !lost_.exchange( true, std::memory_order_acq_rel ) )
         {
-                FFFB_F_ERR_S( scope, "failed closing device %x", device_.device_id() ) ;
-                return false ;
+                FFFB_F_ERR_S( scope, "failed sending report to device %x, suspending reports until the session is reopened", device_.device_id() ) ;
         }
-        return true ;
+        return false ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::_writer_sink ( void * context, report const & report ) noexcept
+{
+        basic_wheel * self = static_cast< basic_wheel * >( context ) ;
+
+        if( !self->online() || self->session_lost() ) return false ;
+
+        return self->_write_device( report, "wheel::writer" ) ;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-constexpr bool wheel::_init_protocol () const noexcept
+template< typename Protocol >
+constexpr bool basic_wheel< Protocol >::_init_protocol () noexcept
 {
-        auto init_sequence = protocol::init_sequence( protocol_, device_.device_id() ) ;
+        auto init_sequence = Protocol::init_sequence( device_.device_id() ) ;
 
         if( init_sequence.empty() ) return true ;
 
@@ -0,0 +1,190 @@
+//
+//
+//      fffb
+//      scs/channels.hxx
+//
+
+#pragma once
+
+#include <fffb/util/log.hxx>
+#include <fffb/util/types.hxx>
+#include <fffb/force/telemetry.hxx>
+
+#include <cstddef>
+
+#include <scssdk_telemetry.h>
+#include <common/scssdk_telemetry_truck_common_channels.h>
+
+#define FFFB_COMPONENT_X 0b001
+#define FFFB_COMPONENT_Y 0b010
+#define FFFB_COMPONENT_Z 0b100
+
+#define FFFB_COMPONENTS_XYZ ( FFFB_COMPONENT_X | FFFB_COMPONENT_Y | FFFB_COMPONENT_Z )
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// one telemetry channel the plugin listens to and where its value lands in telemetry_state.
+// vector values copy the components selected by the mask, in x y z order, to consecutive destination fields.
+// euler values are heading, pitch, roll in the same way
+
+struct channel_descriptor
+{
+        scs_string_t        name ;
+        scs_u32_t          index ;
+        scs_value_type_t    type ;
+        scs_u32_t          flags ;
+        uti::u32_t        offset ;
+        uti::u8_t     components ;
+        float              scale ;
+        telemetry_field    field ;
+} ;
+
+#define FFFB_CHANNEL_OFFSET( member ) static_cast< uti::u32_t >( offsetof( ::fffb::telemetry_state, member ) )
+
+// adding a channel is one line here plus its destination in telemetry_state
+inline constexpr channel_descriptor telemetry_channels []
+{
+        { SCS_TELEMETRY_TRUCK_CHANNEL_world_placement          , SCS_U32_NIL, SCS_VALUE_TYPE_euler  , SCS_TELEMETRY_CHANNEL_FLAG_no_value, FFFB_CHANNEL_OFFSET( heading                 ), FFFB_COMPONENTS_XYZ, 360.0f, telemetry_field::orientation  },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_speed                    , SCS_U32_NIL, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( speed                   ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::speed        },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_engine_rpm               , SCS_U32_NIL, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( rpm                     ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::rpm          },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_engine_gear              , SCS_U32_NIL, SCS_VALUE_TYPE_s32    , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( gear                    ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::gear         },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_effective_steering       , SCS_U32_NIL, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( steering                ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::steering     },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_effective_throttle       , SCS_U32_NIL, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( throttle                ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::throttle     },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_effective_brake          , SCS_U32_NIL, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( brake                   ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::brake        },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_effective_clutch         , SCS_U32_NIL, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( clutch                  ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::clutch       },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_wheel_substance          ,           0, SCS_VALUE_TYPE_u32    , SCS_TELEMETRY_CHANNEL_FLAG_no_value, FFFB_CHANNEL_OFFSET( substance_l             ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::substance_l  },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_wheel_substance          ,           1, SCS_VALUE_TYPE_u32    , SCS_TELEMETRY_CHANNEL_FLAG_no_value, FFFB_CHANNEL_OFFSET( substance_r             ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::substance_r  },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_local_linear_acceleration, SCS_U32_NIL, SCS_VALUE_TYPE_fvector, SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( lateral_accel           ), FFFB_COMPONENTS_XYZ,   1.0f, telemetry_field::acceleration },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_wheel_susp_deflection    ,           0, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( suspension_deflection_l ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::deflection_l },
+        { SCS_TELEMETRY_TRUCK_CHANNEL_wheel_susp_deflection    ,           1, SCS_VALUE_TYPE_float  , SCS_TELEMETRY_CHANNEL_FLAG_none    , FFFB_CHANNEL_OFFSET( suspension_deflection_r ), FFFB_COMPONENT_X   ,   1.0f, telemetry_field::deflection_r },
+} ;
+
+inline constexpr uti::ssize_t telemetry_channel_count { static_cast< uti::ssize_t >( sizeof( telemetry_channels ) / sizeof( channel_descriptor ) ) } ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// what a registered callback gets as its context
+struct channel_binding
+{
+        telemetry_state          * state ;
+        channel_descriptor const * channel ;
+} ;
+
+namespace _detail
+{
+
+
+// writes the selected components to consecutive floats, unselected ones go to a sink instead of branching
+constexpr void store_components ( float * _dst_, float const * _src_, uti::u8_t const _mask_, float const _scale_ ) noexcept
+{
+        float sink { 0.0f } ;
+        uti::ssize_t next { 0 } ;
+
+        for( uti::ssize_t c = 0; c < 3; ++c )
+        {
+                bool const selected = ( _mask_ >> c ) & 1 ;
+
+                *( selected ? _dst_ + next : &sink ) = _src_[ c ] * _scale_ ;
+                next += selected ;
+        }
+}
+
+
+} // namespace _detail
+
+// one instantiation per scs value type, picked at registration time so the callback itself never switches on the type
+template< scs_value_type_t Type >
+SCSAPI_VOID store_channel ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context )
+{
+        channel_binding    const & binding = *static_cast< channel_binding const * >( context ) ;
+        channel_descriptor const & channel = *binding.channel ;
+
+        telemetry_state & state = *binding.state ;
+        uti::u64_t const    bit = field_bit( channel.field ) ;
+
+        state.dirty |= bit ;
+
+        // only channels registered with no_value get here without one
+        if( !value ) return ;
+
+        void * const dst = reinterpret_cast< char * >( &state ) + channel.offset ;
+
+        if constexpr( Type == SCS_VALUE_TYPE_float )
+        {
+                *static_cast< float * >( dst ) = value->value_float.value * channel.scale ;
+        }
+        else if constexpr( Type == SCS_VALUE_TYPE_s32 )
+        {
+                *static_cast< int * >( dst ) = value->value_s32.value ;
+        }
+        else if constexpr( Type == SCS_VALUE_TYPE_u32 )
+        {
+                *static_cast< int * >( dst ) = static_cast< int >( value->value_u32.value ) ;
+        }
+        else if constexpr( Type == SCS_VALUE_TYPE_fvector )
+        {
+                float const src [ 3 ] { value->value_fvector.x, value->value_fvector.y, value->value_fvector.z } ;
+                _detail::store_components( static_cast< float * >( dst ), src, channel.components, channel.scale ) ;
+        }
+        else if constexpr( Type == SCS_VALUE_TYPE_euler )
+        {
+                float const src [ 3 ] { value->value_euler.heading, value->value_euler.pitch, value->value_euler.roll } ;
+                _detail::store_components( static_cast< float * >( dst ), src, channel.components, channel.scale ) ;
+        }
+}
+
+constexpr scs_telemetry_channel_callback_t store_channel_for ( scs_value_type_t const _type_ ) noexcept
+{
+        switch( _type_ )
+        {
+                case SCS_VALUE_TYPE_float   : return store_channel< SCS_VALUE_TYPE_float   > ;
+                case SCS_VALUE_TYPE_s32     : return store_channel< SCS_VALUE_TYPE_s32     > ;
+                case SCS_VALUE_TYPE_u32     : return store_channel< SCS_VALUE_TYPE_u32     > ;
+                case SCS_VALUE_TYPE_fvector : return store_channel< SCS_VALUE_TYPE_fvector > ;
+                case SCS_VALUE_TYPE_euler   : return store_channel< SCS_VALUE_TYPE_euler   > ;
+                default                     : return nullptr ;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// registers every table entry, _bindings_ must outlive the registration and hold telemetry_channel_count entries.
+// returns the number of channels the game accepted, the rest are logged and left at their defaults
+inline uti::ssize_t register_channels ( scs_telemetry_register_for_channel_t const _register_,
+                                        telemetry_state                          & _state_   ,
+                                        channel_binding                          * _bindings_ ) noexcept
+{
+        uti::ssize_t registered { 0 } ;
+
+        for( uti::ssize_t i = 0; i < telemetry_channel_count; ++i )
+        {
+                channel_descriptor const & channel = telemetry_channels[ i ] ;
+
+                scs_telemetry_channel_callback_t const store = store_channel_for( channel.type ) ;
+
+                if( !store )
+                {
+                        FFFB_F_ERR_S( "scs::register_channels", "no store for value type %u of channel %s", channel.type, channel.name ) ;
+                        continue ;
+                }
+                _bindings_[ i ] = { &_state_, &channel } ;
+
+                if( _register_( channel.name, channel.index, channel.type, channel.flags, store, &_bindings_[ i ] ) != SCS_RESULT_ok )
+                {
+                        FFFB_F_WARN_S( "scs::register_channels", "failed registering channel %s[%u]", channel.name, channel.index ) ;
+                        continue ;
+                }
+                ++registered ;
+        }
+        return registered ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,87 @@
+//
+//
+//      fffb
+//      util/alloc_guard.hxx
+//
+
+#pragma once
+
+#include <uti/core/type/traits.hxx>
+#include <uti/core/allocator/resource.hxx>
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef FFFB_ASSERT_NO_ALLOC
+#define FFFB_NO_ALLOC_SCOPE( scope ) fffb::no_alloc_scope _fffb_no_alloc_scope_{ scope }
+#else
+#define FFFB_NO_ALLOC_SCOPE( scope )
+#endif // FFFB_ASSERT_NO_ALLOC
+
+
+namespace fffb
+{
+
+
+namespace _detail
+{
+
+
+inline thread_local char const * g_no_alloc_scope { nullptr } ;
+
+
+constexpr void check_no_alloc ( [[ maybe_unused ]] char const * what ) noexcept
+{
+#ifdef FFFB_ASSERT_NO_ALLOC
+        if( g_no_alloc_scope != nullptr )
+        {
+                // the logger itself may allocate, report straight to stderr
+                fprintf( stderr, "fffb::fatal : %s : heap %s inside no-allocation scope\n", g_no_alloc_scope, what ) ;
+                abort() ;
+        }
+#endif // FFFB_ASSERT_NO_ALLOC
+}
+
+
+} // namespace _detail
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// marks the enclosing block as allocation free, any fffb container allocating inside it aborts
+// only active when built with FFFB_ASSERT_NO_ALLOC
+
+struct no_alloc_scope
+{
+        constexpr no_alloc_scope ( char const * scope ) noexcept : prev_{ _detail::g_no_alloc_scope } { _detail::g_no_alloc_scope = scope ; }
+        constexpr ~no_alloc_scope (                   ) noexcept                                     { _detail::g_no_alloc_scope = prev_ ; }
+
+        no_alloc_scope             ( no_alloc_scope const & ) = delete ;
+        no_alloc_scope & operator= ( no_alloc_scope const & ) = delete ;
+private:
+        char const * prev_ ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct checked_malloc_resource : uti::malloc_resource
+{
+        using _base = uti::malloc_resource ;
+
+        [[ nodiscard ]] static constexpr block_type allocate ( ssize_type const _bytes_, ssize_type const _align_ ) noexcept
+        {
+                _detail::check_no_alloc( "allocation" ) ;
+                return _base::allocate( _bytes_, _align_ ) ;
+        }
+
+        static constexpr void reallocate ( block_type & _block_, ssize_type const _bytes_, ssize_type const _align_ ) noexcept
+        {
+                _detail::check_no_alloc( "reallocation" ) ;
+                _base::reallocate( _block_, _bytes_, _align_ ) ;
+        }
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
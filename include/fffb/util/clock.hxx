@@ -0,0 +1,83 @@
+//
+//
+//      fffb
+//      util/clock.hxx
+//
+
+#pragma once
+
+#include <uti/core/type/traits.hxx>
+
+#include <ctime>
+#include <cerrno>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif // __APPLE__
+
+
+namespace fffb
+{
+
+
+using nanoseconds_t = uti::u64_t ;
+
+constexpr nanoseconds_t ns_per_sec { 1000000000ull } ;
+
+
+namespace _detail
+{
+
+
+#ifdef __APPLE__
+
+constexpr mach_timebase_info_data_t timebase () noexcept
+{
+        mach_timebase_info_data_t info ;
+        mach_timebase_info( &info ) ;
+
+        return info ;
+}
+
+#endif // __APPLE__
+
+
+} // namespace _detail
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+[[ nodiscard ]] constexpr nanoseconds_t monotonic_now () noexcept
+{
+        timespec time ;
+        clock_gettime( CLOCK_MONOTONIC, &time ) ;
+
+        return static_cast< nanoseconds_t >( time.tv_sec ) * ns_per_sec + static_cast< nanoseconds_t >( time.tv_nsec ) ;
+}
+
+// sleeps until an absolute point on the monotonic clock,
+// deadlines don't drift with the time spent between sleeps
+
+constexpr void sleep_until ( nanoseconds_t const deadline ) noexcept
+{
+#ifdef __APPLE__
+        static mach_timebase_info_data_t const info = _detail::timebase() ;
+
+        nanoseconds_t const now = monotonic_now() ;
+
+        if( deadline <= now ) return ;
+
+        uti::u64_t const delta_abs = ( deadline - now ) * info.denom / info.numer ;
+
+        mach_wait_until( mach_absolute_time() + delta_abs ) ;
+#else
+        timespec const ts { static_cast< time_t >( deadline / ns_per_sec ), static_cast< long >( deadline % ns_per_sec ) } ;
+
+        while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr ) == EINTR ) {}
+#endif // __APPLE__
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,20 @@
+//
+//
+//      fffb
+//      util/config.hxx
+//
+
+#pragma once
+
+#ifndef   FFFB_CACHE_LINE_SIZE
+#define   FFFB_CACHE_LINE_SIZE 64
+#endif // FFFB_CACHE_LINE_SIZE
+
+// hid backend, normally picked by cmake per platform. the null backend is only for offline tools
+#if !defined( FFFB_HID_BACKEND_IOKIT ) && !defined( FFFB_HID_BACKEND_HIDRAW ) && !defined( FFFB_HID_BACKEND_NULL )
+#       ifdef __APPLE__
+#               define FFFB_HID_BACKEND_IOKIT
+#       else
+#               define FFFB_HID_BACKEND_HIDRAW
+#       endif
+#endif
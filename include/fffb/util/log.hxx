@@ -6,17 +6,43 @@
 
 #pragma once
 
+#include <fffb/util/config.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/util/spsc_queue.hxx>
+
+#include <uti/core/type/traits.hxx>
 #include <uti/core/string/string.hxx>
 #include <uti/core/string/string_view.hxx>
 
+#include <atomic>
 #include <ctime>
-#include <cstdarg>
 #include <cstdio>
+#include <cstring>
 
 #include <pthread.h>
 
 #define FFFB_LOG_FILE_PATH "/tmp/fffb.log"
 
+// per-record argument limit, extra arguments are a compile error at the call site
+#ifndef   FFFB_LOG_MAX_ARGS
+#define   FFFB_LOG_MAX_ARGS 8
+#endif // FFFB_LOG_MAX_ARGS
+
+// number of threads that can log through the async path at once, others fall back to synchronous writes
+#ifndef   FFFB_LOG_MAX_THREADS
+#define   FFFB_LOG_MAX_THREADS 8
+#endif // FFFB_LOG_MAX_THREADS
+
+#ifndef   FFFB_LOG_RING_LEN
+#define   FFFB_LOG_RING_LEN 128
+#endif // FFFB_LOG_RING_LEN
+
+#define FFFB_LOG_FLUSH_INTERVAL_NS ( 5 * 1000 * 1000 )
+#define FFFB_LOG_LINE_LEN          1024
+
+// room for the one string a record may copy, see log_copy()
+#define FFFB_LOG_TEXT_LEN 64
+
 #define FFFB_VTSEQ(ID) ("\x1b[" #ID "m")
 
 #ifndef   FFFB_LOG_LVL
@@ -154,6 +180,7 @@
 #endif // FFFB_LOGS
 
 
+
 namespace fffb
 {
 
@@ -187,10 +214,10 @@ struct log_file
         FILE * fptr ;
 } ;
 
-static log_file g_log_file( FFFB_LOG_FILE_PATH ) ;
+inline log_file g_log_file( FFFB_LOG_FILE_PATH ) ;
 
 
-enum class log_level
+enum class log_level : uti::u8_t
 {
         succ ,
         fail ,
@@ -205,142 +232,585 @@ namespace _detail
 {
 
 
-constexpr timespec time_empty () noexcept
+////////////////////////////////////////////////////////////////////////////////
+
+// arguments are captured raw and widened, formatting happens later on the logger thread
+// string arguments are captured by pointer and must outlive the record (literals, static tables),
+// anything else goes through log_copy() and is copied into the record
+
+enum class log_arg_type : uti::u8_t
+{
+        sint ,
+        uint ,
+        real ,
+        str  ,
+        text ,
+        ptr  ,
+} ;
+
+struct log_text
+{
+        char const * str ;
+} ;
+
+struct log_arg
+{
+        log_arg_type type ;
+
+        union
+        {
+                uti::i64_t   sint ;
+                uti::u64_t   uint ;
+                double       real ;
+                char const * str  ;
+                void const * ptr  ;
+        } ;
+} ;
+
+template< typename T >
+constexpr log_arg make_log_arg ( T const _value_ ) noexcept
 {
-        return { 0, 0 } ;
+        log_arg arg {} ;
+
+        if constexpr( uti::is_enum_v< T > )
+        {
+                return make_log_arg( static_cast< uti::underlying_type_t< T > >( _value_ ) ) ;
+        }
+        else if constexpr( uti::is_same_v< T, log_text > )
+        {
+                arg.type = log_arg_type::text ;
+                arg.str  = _value_.str ;
+        }
+        else if constexpr( uti::is_floating_point_v< T > )
+        {
+                arg.type = log_arg_type::real ;
+                arg.real = static_cast< double >( _value_ ) ;
+        }
+        else if constexpr( uti::is_integral_v< T > && uti::is_signed_v< T > )
+        {
+                arg.type = log_arg_type::sint ;
+                arg.sint = static_cast< uti::i64_t >( _value_ ) ;
+        }
+        else if constexpr( uti::is_integral_v< T > )
+        {
+                arg.type = log_arg_type::uint ;
+                arg.uint = static_cast< uti::u64_t >( _value_ ) ;
+        }
+        else if constexpr( uti::is_pointer_v< T > && uti::is_same_v< uti::remove_cv_t< uti::remove_pointer_t< T > >, char > )
+        {
+                arg.type = log_arg_type::str ;
+                arg.str  = _value_ ;
+        }
+        else if constexpr( uti::is_pointer_v< T > )
+        {
+                arg.type = log_arg_type::ptr ;
+                arg.ptr  = static_cast< void const * >( _value_ ) ;
+        }
+        else
+        {
+                static_assert( uti::always_false_v< T >, "fffb::log: unsupported log argument type" ) ;
+        }
+        return arg ;
 }
 
-constexpr timespec time_current () noexcept
+struct log_record
 {
-        timespec time ;
-        clock_gettime( CLOCK_REALTIME, &time ) ;
+        nanoseconds_t timestamp ;
+        FILE       *       dest ;
+        char const *      scope ;
+        char const *        fmt ;
+        log_level         level ;
+        uti::u8_t          argc ;
+        log_arg            args [ FFFB_LOG_MAX_ARGS ] ;
+        char               text [ FFFB_LOG_TEXT_LEN ] ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
 
-        return time ;
+constexpr void advance ( uti::ssize_t & _len_, uti::ssize_t const _cap_, int const _written_ ) noexcept
+{
+        if( _written_ <= 0 ) return ;
+
+        _len_ = _len_ + _written_ < _cap_ ? _len_ + _written_ : _cap_ - 1 ;
 }
 
-constexpr timespec time_current_mono () noexcept
+// HH:MM:SS:mmm
+constexpr void format_time ( char * _out_, tm const & _tms_, uti::i32_t const _msec_ ) noexcept
 {
-        timespec time ;
-        clock_gettime( CLOCK_MONOTONIC_RAW, &time ) ;
+        _out_[  0 ] = '0' + ( _tms_.tm_hour / 10 ) ;
+        _out_[  1 ] = '0' + ( _tms_.tm_hour % 10 ) ;
+        _out_[  2 ] = ':' ;
+        _out_[  3 ] = '0' + ( _tms_.tm_min / 10 ) ;
+        _out_[  4 ] = '0' + ( _tms_.tm_min % 10 ) ;
+        _out_[  5 ] = ':' ;
+        _out_[  6 ] = '0' + ( _tms_.tm_sec / 10 ) ;
+        _out_[  7 ] = '0' + ( _tms_.tm_sec % 10 ) ;
+        _out_[  8 ] = ':' ;
+        _out_[  9 ] = '0' + ( _msec_ / 100 )      ;
+        _out_[ 10 ] = '0' + ( _msec_ /  10 ) % 10 ;
+        _out_[ 11 ] = '0' + ( _msec_ %  10 )      ;
+        _out_[ 12 ] = '\0' ;
+}
+
+constexpr uti::ssize_t format_prefix ( char * _out_, uti::ssize_t const _cap_, log_level const _level_, char const * _time_, char const * _scope_ ) noexcept
+{
+        char const * color  = terminal_red () ;
+        char const * weight = terminal_bold() ;
+        char         label [ 8 ] ;
 
-        return time ;
+        switch( _level_ )
+        {
+                case log_level::dbg : color = terminal_purple() ; memcpy( label, "dbg ", 5 ) ; break ;
+                case log_level::info: color =                "" ; memcpy( label, "info", 5 ) ; break ;
+                case log_level::warn: color = terminal_yellow() ; memcpy( label, "warn", 5 ) ; break ;
+                case log_level::err : color = terminal_red   () ; memcpy( label, "err ", 5 ) ; break ;
+                case log_level::succ: color = terminal_green () ; memcpy( label, "succ", 5 ) ; break ;
+                case log_level::fail: color = terminal_red   () ; memcpy( label, "fail", 5 ) ; break ;
+                default:
+                        weight = terminal_faint() ;
+                        snprintf( label, sizeof( label ), "%4d", uti::to_underlying( _level_ ) ) ;
+                        break ;
+        }
+        uti::ssize_t len { 0 } ;
+
+        advance( len, _cap_, snprintf( _out_, _cap_, "%s%s:: %s : fffb::%s : ", color, weight, _time_, label ) ) ;
+
+        if( _scope_ != nullptr )
+        {
+                advance( len, _cap_, snprintf( _out_ + len, _cap_ - len, "%s : ", _scope_ ) ) ;
+        }
+        advance( len, _cap_, snprintf( _out_ + len, _cap_ - len, "%s", terminal_reset() ) ) ;
+
+        return len ;
+}
+
+constexpr int format_arg ( char * _out_, uti::ssize_t const _cap_, char const * _spec_, char const _conv_,
+                           int const * _stars_, int const _star_count_, log_arg const & _arg_ ) noexcept
+{
+        auto emit = [ & ]( auto const value ) -> int
+        {
+                switch( _star_count_ )
+                {
+                        case  0: return snprintf( _out_, _cap_, _spec_,                             value ) ;
+                        case  1: return snprintf( _out_, _cap_, _spec_, _stars_[ 0 ],               value ) ;
+                        default: return snprintf( _out_, _cap_, _spec_, _stars_[ 0 ], _stars_[ 1 ], value ) ;
+                }
+        } ;
+        switch( _conv_ )
+        {
+                case 'd': case 'i':
+                        return emit( _arg_.type == log_arg_type::real ? static_cast< long long >( _arg_.real ) : static_cast< long long >( _arg_.sint ) ) ;
+                case 'o': case 'u': case 'x': case 'X':
+                        return emit( _arg_.type == log_arg_type::real ? static_cast< unsigned long long >( _arg_.real ) : static_cast< unsigned long long >( _arg_.uint ) ) ;
+                case 'c':
+                        return emit( static_cast< int >( _arg_.sint ) ) ;
+                case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                        return emit( _arg_.type == log_arg_type::real ? _arg_.real
+                                   : _arg_.type == log_arg_type::sint ? static_cast< double >( _arg_.sint )
+                                   :                                    static_cast< double >( _arg_.uint ) ) ;
+                case 's':
+                        return emit( ( _arg_.type == log_arg_type::str || _arg_.type == log_arg_type::text ) && _arg_.str != nullptr ? _arg_.str : "(null)" ) ;
+                case 'p':
+                        return emit( _arg_.ptr ) ;
+                default:
+                        return snprintf( _out_, _cap_, "<%%%c?>", _conv_ ) ;
+        }
+}
+
+// walks the printf format and re-issues each conversion with the widened argument,
+// integer length modifiers are normalized to 'll' since every integer was recorded as 64 bits
+
+constexpr uti::ssize_t format_message ( char * _out_, uti::ssize_t const _cap_, char const * _fmt_, log_arg const * _args_, uti::ssize_t const _argc_ ) noexcept
+{
+        uti::ssize_t len { 0 } ;
+        uti::ssize_t arg { 0 } ;
+
+        for( char const * p = _fmt_; *p != '\0' && len < _cap_ - 1; ++p )
+        {
+                if( *p != '%' )
+                {
+                        _out_[ len++ ] = *p ;
+                        continue ;
+                }
+                if( p[ 1 ] == '%' )
+                {
+                        _out_[ len++ ] = '%' ;
+                        ++p ;
+                        continue ;
+                }
+                char spec [ 32 ] ;
+                int  spec_len { 0 } ;
+
+                int stars [ 2 ] { 0, 0 } ;
+                int star_count  { 0 } ;
+
+                spec[ spec_len++ ] = '%' ;
+                ++p ;
+
+                while( *p != '\0' && strchr( "-+ #0123456789.*", *p ) != nullptr )
+                {
+                        if( *p == '*' && star_count < 2 && arg < _argc_ )
+                        {
+                                stars[ star_count++ ] = static_cast< int >( _args_[ arg++ ].sint ) ;
+                        }
+                        if( spec_len < 24 ) spec[ spec_len++ ] = *p ;
+                        ++p ;
+                }
+                while( *p != '\0' && strchr( "hljztLq", *p ) != nullptr ) ++p ;
+
+                char const conv = *p ;
+
+                if( conv == '\0' ) break ;
+
+                if( strchr( "diouxX", conv ) != nullptr )
+                {
+                        spec[ spec_len++ ] = 'l' ;
+                        spec[ spec_len++ ] = 'l' ;
+                }
+                spec[ spec_len++ ] = conv ;
+                spec[ spec_len   ] = '\0' ;
+
+                if( arg >= _argc_ )
+                {
+                        advance( len, _cap_, snprintf( _out_ + len, _cap_ - len, "<missing>" ) ) ;
+                        continue ;
+                }
+                advance( len, _cap_, format_arg( _out_ + len, _cap_ - len, spec, conv, stars, star_count, _args_[ arg++ ] ) ) ;
+        }
+        _out_[ len ] = '\0' ;
+
+        return len ;
 }
 
-constexpr string time_string ()
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace _detail
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// call sites only copy a fixed-size record into a ring owned by the calling thread,
+// a background thread formats the records and writes them out in batches.
+// when a ring is full the record is dropped and counted instead of blocking the caller.
+// until start() is called, and after stop(), records are written synchronously on the calling thread
+
+class async_logger
 {
-        string time_str( 2 + 1 + 2 + 1 + 2 + 1 + 3 + 1 ) ; // HH:MM:SS:mmm\0
+        using record = _detail::log_record ;
+
+        enum ring_state : uti::u8_t
+        {
+                ring_free     ,
+                ring_owned    ,
+                ring_retiring ,
+        } ;
+
+        struct ring
+        {
+                std::atomic< uti::u8_t  >   state { ring_free } ;
+                std::atomic< uti::u64_t > dropped {         0 } ;
+
+                spsc_queue< record, FFFB_LOG_RING_LEN > queue ;
+        } ;
+
+        // returns the ring to the pool when its thread exits, the logger drains what's left first
+        struct ring_handle
+        {
+                ring * owned   { nullptr } ;
+                bool   claimed {   false } ;
+
+                constexpr ~ring_handle () noexcept { if( owned ) owned->state.store( ring_retiring, std::memory_order_release ) ; }
+        } ;
+public:
+        constexpr  async_logger () noexcept = default ;
+        constexpr ~async_logger () noexcept {  stop() ; }
+
+        async_logger             ( async_logger const & ) = delete ;
+        async_logger & operator= ( async_logger const & ) = delete ;
+
+        constexpr bool start () noexcept ;
+        constexpr void stop  () noexcept ;
+
+        [[ nodiscard ]] constexpr bool running () const noexcept { return running_.load( std::memory_order_acquire ) ; }
+
+        template< typename... Args >
+        constexpr void push ( FILE * _dest_, log_level _level_, char const * _scope_, char const * _fmt_, Args... _args_ ) noexcept ;
+
+        // records dropped because a ring was full, reported and cleared on every drain
+        [[ nodiscard ]] constexpr uti::u64_t dropped () const noexcept { return dropped_total_.load( std::memory_order_relaxed ) ; }
+private:
+        ring rings_ [ FFFB_LOG_MAX_THREADS ] ;
+
+        pthread_t thread_ {} ;
+
+        std::atomic< bool >           running_ { false } ;
+        std::atomic< uti::u64_t > dropped_total_ {     0 } ;
 
-        timespec time = time_current() ;
+        // logger thread only
+        nanoseconds_t wall_offset_ {  0 } ;
+        time_t        cached_sec_  { -1 } ;
+        tm            cached_tm_   {    } ;
 
-        struct tm const * tms = localtime( &time.tv_sec ) ;
+        constexpr ring * _local_ring () noexcept ;
 
-        uti::i32_t msec = time.tv_nsec / 1000000 ;
+        constexpr void _drain () noexcept ;
 
-        time_str.push_back( '0' + ( tms->tm_hour / 10 ) ) ;
-        time_str.push_back( '0' + ( tms->tm_hour % 10 ) ) ;
-        time_str.push_back( ':' ) ;
-        time_str.push_back( '0' + ( tms->tm_min / 10 ) ) ;
-        time_str.push_back( '0' + ( tms->tm_min % 10 ) ) ;
-        time_str.push_back( ':' ) ;
-        time_str.push_back( '0' + ( tms->tm_sec / 10 ) ) ;
-        time_str.push_back( '0' + ( tms->tm_sec % 10 ) ) ;
-        time_str.push_back( ':' ) ;
-        time_str.push_back( '0' + ( msec / 100 )      ) ;
-        time_str.push_back( '0' + ( msec /  10 ) % 10 ) ;
-        time_str.push_back( '0' + ( msec %  10 )      ) ;
+        constexpr void _write_record ( record const & _record_ ) noexcept ;
 
-        return time_str ;
+        static constexpr void _write_sync ( record const & _record_ ) noexcept ;
+
+        static constexpr uti::ssize_t _format ( char * _out_, uti::ssize_t _cap_, record const & _record_, char const * _time_ ) noexcept ;
+
+        static constexpr nanoseconds_t _realtime_now () noexcept ;
+
+        static constexpr void * _run ( void * _self_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool async_logger::start () noexcept
+{
+        if( running() ) return true ;
+
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                running_.store( false, std::memory_order_release ) ;
+                return false ;
+        }
+        return true ;
 }
 
-constexpr void log_2_v ( FILE * dest, log_level level, char const * fmt, va_list args )
+constexpr void async_logger::stop () noexcept
 {
-        string time = time_string() ;
+        if( !running() ) return ;
 
-        switch( level )
+        running_.store( false, std::memory_order_release ) ;
+        pthread_join( thread_, nullptr ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename... Args >
+constexpr void async_logger::push ( FILE * _dest_, log_level _level_, char const * _scope_, char const * _fmt_, Args... _args_ ) noexcept
+{
+        static_assert( sizeof...( Args ) <= FFFB_LOG_MAX_ARGS, "fffb::log: too many log arguments" ) ;
+        static_assert( ( 0 + ... + uti::is_same_v< Args, _detail::log_text > ) <= 1, "fffb::log: at most one log_copy() per record" ) ;
+
+        record rec ;
+
+        rec.timestamp = monotonic_now() ;
+        rec.dest      = _dest_ ? _dest_ : stderr ;
+        rec.scope     = _scope_ ;
+        rec.fmt       = _fmt_ ;
+        rec.level     = _level_ ;
+        rec.argc      = sizeof...( Args ) ;
+
+        uti::ssize_t i { 0 } ;
+        ( ( rec.args[ i++ ] = _detail::make_log_arg( _args_ ) ), ... ) ;
+
+        // the caller's buffer may be gone by the time the record is formatted
+        for( uti::ssize_t a = 0; a < rec.argc; ++a )
         {
-                case log_level::dbg:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::dbg  : ", terminal_purple(), terminal_bold(), SV_ARG( time ) ) ;
-                        break ;
-                case log_level::info:
-                        fprintf( dest, "%s:: " SV_FMT " : fffb::info : ", terminal_bold(), SV_ARG( time ) ) ;
-                        break ;
-                case log_level::warn:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::warn : ", terminal_yellow(), terminal_bold(), SV_ARG( time ) ) ;
-                        break ;
-                case log_level::err:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::err  : ", terminal_red(), terminal_bold(), SV_ARG( time ) ) ;
-                        break ;
-                case log_level::succ:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::succ : ", terminal_green(), terminal_bold(), SV_ARG( time ) ) ;
-                        break ;
-                case log_level::fail:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::fail : ", terminal_red(), terminal_bold(), SV_ARG( time ) ) ;
-                        break ;
-                default:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::%4d : ", terminal_red(), terminal_faint(), SV_ARG( time ), uti::to_underlying( level ) ) ;
-                        break ;
+                if( rec.args[ a ].type != _detail::log_arg_type::text ) continue ;
+
+                snprintf( rec.text, sizeof( rec.text ), "%s", rec.args[ a ].str ? rec.args[ a ].str : "(null)" ) ;
+                rec.args[ a ].str = nullptr ;
         }
-        fprintf( dest, "%s", terminal_reset() ) ;
 
-        vfprintf( dest, fmt, args ) ;
-        fprintf( dest, "\n" ) ;
+        ring * local = running() ? _local_ring() : nullptr ;
+
+        if( local == nullptr )
+        {
+                _write_sync( rec ) ;
+                return ;
+        }
+        if( !local->queue.push( rec ) )
+        {
+                local->dropped.fetch_add( 1, std::memory_order_relaxed ) ;
+        }
 }
 
-constexpr void log_3_v ( FILE * dest, log_level level, char const * scope, char const * fmt, va_list args )
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr async_logger::ring * async_logger::_local_ring () noexcept
 {
-        string time = time_string() ;
+        static thread_local ring_handle handle ;
+
+        if( handle.claimed ) return handle.owned ;
 
-        switch( level )
+        handle.claimed = true ;
+
+        for( ring & r : rings_ )
         {
-                case log_level::dbg:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::dbg  : %s : ", terminal_purple(), terminal_bold(), SV_ARG( time ), scope ) ;
-                        break ;
-                case log_level::info:
-                        fprintf( dest, "%s:: " SV_FMT " : fffb::info : %s : ", terminal_bold(), SV_ARG( time ), scope ) ;
-                        break ;
-                case log_level::warn:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::warn : %s : ", terminal_yellow(), terminal_bold(), SV_ARG( time ), scope ) ;
-                        break ;
-                case log_level::err:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::err  : %s : ", terminal_red(), terminal_bold(), SV_ARG( time ), scope) ;
-                        break ;
-                case log_level::succ:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::succ : %s : ", terminal_green(), terminal_bold(), SV_ARG( time ), scope ) ;
-                        break ;
-                case log_level::fail:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::fail : %s : ", terminal_red(), terminal_bold(), SV_ARG( time ), scope ) ;
-                        break ;
-                default:
-                        fprintf( dest, "%s%s:: " SV_FMT " : fffb::%4d : %s : ", terminal_red(), terminal_faint(), SV_ARG( time ), uti::to_underlying( level ), scope ) ;
+                uti::u8_t expected { ring_free } ;
+
+                if( r.state.compare_exchange_strong( expected, ring_owned, std::memory_order_acq_rel ) )
+                {
+                        handle.owned = &r ;
                         break ;
+                }
+        }
+        return handle.owned ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void async_logger::_drain () noexcept
+{
+        wall_offset_ = _realtime_now() - monotonic_now() ;
+
+        FILE * touched [ 2 ] { nullptr, nullptr } ;
+
+        for( ring & r : rings_ )
+        {
+                uti::u8_t const state = r.state.load( std::memory_order_acquire ) ;
+
+                if( state == ring_free ) continue ;
+
+                record rec ;
+
+                while( r.queue.pop( rec ) )
+                {
+                        _write_record( rec ) ;
+
+                        if     ( touched[ 0 ] == nullptr || touched[ 0 ] == rec.dest ) touched[ 0 ] = rec.dest ;
+                        else if( touched[ 1 ] == nullptr || touched[ 1 ] == rec.dest ) touched[ 1 ] = rec.dest ;
+                        else                                                           fflush( rec.dest ) ;
+                }
+                if( uti::u64_t const dropped = r.dropped.exchange( 0, std::memory_order_relaxed ); dropped > 0 )
+                {
+                        dropped_total_.fetch_add( dropped, std::memory_order_relaxed ) ;
+
+                        record note {} ;
+
+                        note.timestamp = monotonic_now() ;
+                        note.dest      = g_log_file.fptr ? g_log_file.fptr : stderr ;
+                        note.scope     = "async_logger" ;
+                        note.fmt       = "log ring full, dropped %llu records" ;
+                        note.level     = log_level::warn ;
+                        note.argc      = 1 ;
+                        note.args[ 0 ] = _detail::make_log_arg( dropped ) ;
+
+                        _write_record( note ) ;
+                        fflush( note.dest ) ;
+                }
+                if( state == ring_retiring && r.queue.empty() )
+                {
+                        uti::u8_t expected { ring_retiring } ;
+                        r.state.compare_exchange_strong( expected, ring_free, std::memory_order_acq_rel ) ;
+                }
+        }
+        if( touched[ 0 ] ) fflush( touched[ 0 ] ) ;
+        if( touched[ 1 ] ) fflush( touched[ 1 ] ) ;
+}
+
+constexpr void async_logger::_write_record ( record const & _record_ ) noexcept
+{
+        nanoseconds_t const wall = _record_.timestamp + wall_offset_ ;
+        time_t        const sec  = static_cast< time_t >( wall / ns_per_sec ) ;
+
+        if( sec != cached_sec_ )
+        {
+                localtime_r( &sec, &cached_tm_ ) ;
+                cached_sec_ = sec ;
         }
-        fprintf( dest, "%s", terminal_reset() ) ;
+        char time [ 13 ] ;
+        _detail::format_time( time, cached_tm_, static_cast< uti::i32_t >( ( wall % ns_per_sec ) / 1000000 ) ) ;
 
-        vfprintf( dest, fmt, args ) ;
-        fprintf( dest, "\n" ) ;
+        char line [ FFFB_LOG_LINE_LEN ] ;
+        uti::ssize_t const len = _format( line, sizeof( line ), _record_, time ) ;
+
+        fwrite( line, 1, len, _record_.dest ) ;
 }
 
+constexpr void async_logger::_write_sync ( record const & _record_ ) noexcept
+{
+        nanoseconds_t const wall = _realtime_now() ;
+        time_t        const sec  = static_cast< time_t >( wall / ns_per_sec ) ;
 
-} // namespace _detail
+        tm tms ;
+        localtime_r( &sec, &tms ) ;
+
+        char time [ 13 ] ;
+        _detail::format_time( time, tms, static_cast< uti::i32_t >( ( wall % ns_per_sec ) / 1000000 ) ) ;
+
+        char line [ FFFB_LOG_LINE_LEN ] ;
+        uti::ssize_t const len = _format( line, sizeof( line ), _record_, time ) ;
+
+        fwrite( line, 1, len, _record_.dest ) ;
+        fflush( _record_.dest ) ;
+}
+
+constexpr uti::ssize_t async_logger::_format ( char * _out_, uti::ssize_t _cap_, record const & _record_, char const * _time_ ) noexcept
+{
+        uti::ssize_t len = _detail::format_prefix( _out_, _cap_ - 1, _record_.level, _time_, _record_.scope ) ;
+
+        // a copied string lives in the record, which may have moved since it was pushed
+        _detail::log_arg args [ FFFB_LOG_MAX_ARGS ] ;
+
+        for( uti::ssize_t a = 0; a < _record_.argc; ++a )
+        {
+                args[ a ] = _record_.args[ a ] ;
+
+                if( args[ a ].type == _detail::log_arg_type::text ) args[ a ].str = _record_.text ;
+        }
+        len += _detail::format_message( _out_ + len, _cap_ - 1 - len, _record_.fmt, args, _record_.argc ) ;
+
+        _out_[ len++ ] = '\n' ;
+
+        return len ;
+}
 
-constexpr void log_2 ( FILE * dest, log_level level, char const * fmt, ... )
+constexpr nanoseconds_t async_logger::_realtime_now () noexcept
 {
-        if( dest == nullptr ) dest = stderr ;
+        timespec time ;
+        clock_gettime( CLOCK_REALTIME, &time ) ;
 
-        va_list args ;
-        va_start( args, fmt ) ;
-        _detail::log_2_v( dest, level, fmt, args ) ;
-        va_end( args ) ;
+        return static_cast< nanoseconds_t >( time.tv_sec ) * ns_per_sec + static_cast< nanoseconds_t >( time.tv_nsec ) ;
 }
 
-constexpr void log_3 ( FILE * dest, log_level level, char const * scope, char const * fmt, ... )
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr void * async_logger::_run ( void * _self_ ) noexcept
 {
-        if( dest == nullptr ) dest = stderr ;
+        async_logger * self = static_cast< async_logger * >( _self_ ) ;
 
-        va_list args ;
-        va_start( args, fmt ) ;
-        _detail::log_3_v( dest, level, scope, fmt, args ) ;
-        va_end( args ) ;
+        while( self->running() )
+        {
+                self->_drain() ;
+
+                sleep_until( monotonic_now() + FFFB_LOG_FLUSH_INTERVAL_NS ) ;
+        }
+        self->_drain() ;
+
+        return nullptr ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// one logger and one flush thread for the whole plugin, whichever translation unit logs.
+// the plugin starts it in scs_telemetry_init and joins it in scs_telemetry_shutdown, nothing runs at load
+inline async_logger g_logger ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// copies a string that may not outlive the call (device paths, stack buffers) into the record
+[[ nodiscard ]] constexpr _detail::log_text log_copy ( char const * _str_ ) noexcept { return { _str_ } ; }
+
+template< typename... Args >
+constexpr void log_2 ( FILE * dest, log_level level, char const * fmt, Args... args ) noexcept
+{
+        g_logger.push( dest, level, nullptr, fmt, args... ) ;
+}
+
+template< typename... Args >
+constexpr void log_3 ( FILE * dest, log_level level, char const * scope, char const * fmt, Args... args ) noexcept
+{
+        g_logger.push( dest, level, scope, fmt, args... ) ;
 }
 
 
@@ -0,0 +1,105 @@
+//
+//
+//      fffb
+//      util/seqlock.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+
+#include <uti/core/type/traits.hxx>
+
+#include <atomic>
+#include <cstring>
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// single-writer, multi-reader snapshot of a trivially copyable value
+// readers never block the writer and retry on torn reads,
+// the payload is copied through relaxed atomic words so concurrent reads stay well defined
+
+template< typename T >
+class seqlock
+{
+        static_assert( uti::is_trivially_copyable_v< T >, "fffb::seqlock: value type must be trivially copyable" ) ;
+
+        static constexpr uti::ssize_t word_count { ( sizeof( T ) + sizeof( uti::u64_t ) - 1 ) / sizeof( uti::u64_t ) } ;
+public:
+        using value_type = T ;
+
+        constexpr  seqlock () noexcept = default ;
+        constexpr ~seqlock () noexcept = default ;
+
+        seqlock             ( seqlock const & ) = delete ;
+        seqlock & operator= ( seqlock const & ) = delete ;
+
+        constexpr void store ( value_type const & _value_ ) noexcept ;
+
+        [[ nodiscard ]] constexpr value_type load () const noexcept ;
+
+        // returns the number of completed stores, lets readers tell whether anything new was published
+        [[ nodiscard ]] constexpr uti::u64_t generation () const noexcept { return seq_.load( std::memory_order_acquire ) / 2 ; }
+private:
+        alignas( FFFB_CACHE_LINE_SIZE ) std::atomic< uti::u64_t > seq_ { 0 } ;
+
+        alignas( FFFB_CACHE_LINE_SIZE ) std::atomic< uti::u64_t > words_ [ word_count ] {} ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename T >
+constexpr void seqlock< T >::store ( value_type const & _value_ ) noexcept
+{
+        uti::u64_t buffer [ word_count ] {} ;
+        memcpy( buffer, &_value_, sizeof( value_type ) ) ;
+
+        uti::u64_t const seq = seq_.load( std::memory_order_relaxed ) ;
+
+        seq_.store( seq + 1, std::memory_order_relaxed ) ;
+        std::atomic_thread_fence( std::memory_order_release ) ;
+
+        for( uti::ssize_t i = 0; i < word_count; ++i )
+        {
+                words_[ i ].store( buffer[ i ], std::memory_order_relaxed ) ;
+        }
+        seq_.store( seq + 2, std::memory_order_release ) ;
+}
+
+template< typename T >
+constexpr typename seqlock< T >::value_type seqlock< T >::load () const noexcept
+{
+        uti::u64_t buffer [ word_count ] ;
+        uti::u64_t seq_begin ;
+        uti::u64_t seq_end   ;
+
+        do
+        {
+                seq_begin = seq_.load( std::memory_order_acquire ) ;
+
+                for( uti::ssize_t i = 0; i < word_count; ++i )
+                {
+                        buffer[ i ] = words_[ i ].load( std::memory_order_relaxed ) ;
+                }
+                std::atomic_thread_fence( std::memory_order_acquire ) ;
+
+                seq_end = seq_.load( std::memory_order_relaxed ) ;
+        }
+        while( ( seq_begin & 1 ) || seq_begin != seq_end ) ;
+
+        value_type value ;
+        memcpy( &value, buffer, sizeof( value_type ) ) ;
+
+        return value ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
@@ -0,0 +1,109 @@
+//
+//
+//      fffb
+//      util/spsc_queue.hxx
+//
+
+#pragma once
+
+#include <fffb/util/config.hxx>
+
+#include <uti/core/type/traits.hxx>
+
+#include <atomic>
+
+
+namespace fffb
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// bounded wait-free single-producer/single-consumer ring
+// push() may only be called from one thread, pop() from one other thread
+
+template< typename T, uti::ssize_t Capacity >
+class spsc_queue
+{
+        static_assert( Capacity > 0 && ( Capacity & ( Capacity - 1 ) ) == 0, "fffb::spsc_queue: capacity must be a power of two" ) ;
+
+        static constexpr uti::u64_t mask { Capacity - 1 } ;
+public:
+        using value_type = T ;
+
+        static constexpr uti::ssize_t static_capacity { Capacity } ;
+
+        constexpr  spsc_queue () noexcept = default ;
+        constexpr ~spsc_queue () noexcept = default ;
+
+        spsc_queue             ( spsc_queue const & ) = delete ;
+        spsc_queue & operator= ( spsc_queue const & ) = delete ;
+
+        [[ nodiscard ]] constexpr bool push ( value_type const & _value_ ) noexcept ;
+        [[ nodiscard ]] constexpr bool pop  ( value_type       & _value_ ) noexcept ;
+
+        // safe from any thread but only a snapshot: tail goes first so a pop landing between the loads
+        // can't put it past the head, and pushes landing there can't take it past the capacity
+        [[ nodiscard ]] constexpr uti::ssize_t size () const noexcept
+        {
+                uti::u64_t const tail = tail_.load( std::memory_order_acquire ) ;
+                uti::u64_t const head = head_.load( std::memory_order_acquire ) ;
+
+                if( head <= tail ) return 0 ;
+
+                return head - tail < Capacity ? static_cast< uti::ssize_t >( head - tail ) : Capacity ;
+        }
+        [[ nodiscard ]] constexpr bool empty () const noexcept { return size() == 0 ; }
+
+        [[ nodiscard ]] constexpr uti::ssize_t capacity () const noexcept { return static_capacity ; }
+private:
+        alignas( FFFB_CACHE_LINE_SIZE ) std::atomic< uti::u64_t > head_        { 0 } ;
+                                        uti::u64_t                cached_tail_ { 0 } ;
+
+        alignas( FFFB_CACHE_LINE_SIZE ) std::atomic< uti::u64_t > tail_        { 0 } ;
+                                        uti::u64_t                cached_head_ { 0 } ;
+
+        alignas( FFFB_CACHE_LINE_SIZE ) value_type buffer_ [ Capacity ] {} ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+template< typename T, uti::ssize_t Capacity >
+constexpr bool spsc_queue< T, Capacity >::push ( value_type const & _value_ ) noexcept
+{
+        uti::u64_t const head = head_.load( std::memory_order_relaxed ) ;
+
+        if( head - cached_tail_ == Capacity )
+        {
+                cached_tail_ = tail_.load( std::memory_order_acquire ) ;
+
+                if( head - cached_tail_ == Capacity ) return false ;
+        }
+        buffer_[ head & mask ] = _value_ ;
+        head_.store( head + 1, std::memory_order_release ) ;
+
+        return true ;
+}
+
+template< typename T, uti::ssize_t Capacity >
+constexpr bool spsc_queue< T, Capacity >::pop ( value_type & _value_ ) noexcept
+{
+        uti::u64_t const tail = tail_.load( std::memory_order_relaxed ) ;
+
+        if( tail == cached_head_ )
+        {
+                cached_head_ = head_.load( std::memory_order_acquire ) ;
+
+                if( tail == cached_head_ ) return false ;
+        }
+        _value_ = buffer_[ tail & mask ] ;
+        tail_.store( tail + 1, std::memory_order_release ) ;
+
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb
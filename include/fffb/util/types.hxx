@@ -6,22 +6,28 @@
 
 #pragma once
 
+#include <fffb/util/config.hxx>
 #include <fffb/util/log.hxx>
+#include <fffb/util/alloc_guard.hxx>
 
 #include <uti/core/type/traits.hxx>
 #include <uti/core/container/array.hxx>
 #include <uti/core/container/vector.hxx>
 
+#ifdef FFFB_HID_BACKEND_IOKIT
 #include <IOKit/hid/IOHIDDevice.h>
 #include <IOKit/hid/IOHIDManager.h>
 
 #include <mach/mach_error.h>
+#endif // FFFB_HID_BACKEND_IOKIT
 
 
 namespace fffb
 {
 
 
+#ifdef FFFB_HID_BACKEND_IOKIT
+
 namespace apple
 {
 
@@ -34,6 +40,7 @@ using number      = __CFNumber     ;
 using string      = __CFString     ;
 using array       = __CFArray      ;
 using set         = __CFSet        ;
+using dictionary  = __CFDictionary ;
 using index       =   CFIndex      ;
 
 
@@ -50,11 +57,18 @@ constexpr bool _try ( io_result result, [[ maybe_unused ]] char const * scope )
 
 } // namespace apple
 
+#endif // FFFB_HID_BACKEND_IOKIT
+
 
 using timestamp_t = uti::u64_t ;
 using device_id_t = uti::u32_t ;
 
-template< typename T > using vector = uti::vector< T, uti::allocator< T, uti::malloc_resource > > ;
+[[ nodiscard ]] constexpr device_id_t make_device_id ( uti::u32_t product_id, uti::u32_t vendor_id ) noexcept
+{
+        return ( ( product_id & 0xFFFF ) << 16 ) | ( vendor_id & 0xFFFF ) ;
+}
+
+template< typename T > using vector = uti::vector< T, uti::allocator< T, checked_malloc_resource > > ;
 
 
 } // namespace fffb
@@ -7,9 +7,9 @@
 /// STD
 
 #include <cstdlib>
-#include <cassert>
 #include <cstdarg>
 #include <cstring>
+#include <atomic>
 
 /// SDK
 
@@ -23,20 +23,58 @@
 
 #include <fffb/util/version.hxx>
 #include <fffb/util/types.hxx>
+#include <fffb/util/seqlock.hxx>
 #include <fffb/hid/device.hxx>
+#include <fffb/hid/monitor.hxx>
 #include <fffb/joy/wheel.hxx>
 #include <fffb/force/simulator.hxx>
+#include <fffb/force/scheduler.hxx>
+#include <fffb/scs/channels.hxx>
+#ifdef FFFB_RECORDER
+#include <fffb/force/recorder.hxx>
+#endif // FFFB_RECORDER
 
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
-bool g_telemetry_paused { true } ;
+std::atomic< bool > g_telemetry_paused { true  } ;
+std::atomic< bool > g_wheel_ready      { false } ;
+
+// set by init_wheel, cleared by the first deinit_wheel, shutdown and unload both try
+bool g_wheel_inited { false } ;
 
 fffb::timestamp_t     g_last_timestamp  { static_cast< fffb::timestamp_t >( -1 ) } ;
 fffb::telemetry_state g_telemetry_state {} ;
 fffb::simulator       g_simulator       {} ;
 
+fffb::seqlock< fffb::telemetry_state > g_telemetry_snapshot {} ;
+
+fffb::channel_binding g_channel_bindings [ fffb::telemetry_channel_count ] {} ;
+
+// dirty bits of snapshots the scheduler never loaded carry over into the next one,
+// until the scheduler reports it consumed the latest published generation
+uti::u64_t                g_pending_dirty   { 0 } ;
+uti::u64_t                g_dirty_published { 0 } ;
+std::atomic< uti::u64_t > g_dirty_consumed  { 0 } ;
+
+fffb::ffb_scheduler g_scheduler   {} ;
+bool                g_ffb_stopped { true } ;
+
+fffb::hid_monitor g_monitor            {} ;
+uti::u64_t        g_monitor_generation { 0 } ;
+
+// a wheel the monitor sees but that failed to come up is retried, waiting longer after every failure
+fffb::nanoseconds_t g_reconnect_at      { 0 } ;
+fffb::nanoseconds_t g_reconnect_backoff { 0 } ;
+
+constexpr fffb::nanoseconds_t reconnect_backoff_min { fffb::ns_per_sec / 10 } ;
+constexpr fffb::nanoseconds_t reconnect_backoff_max { fffb::ns_per_sec *  5 } ;
+
+#ifdef FFFB_RECORDER
+fffb::recorder g_recorder {} ;
+#endif // FFFB_RECORDER
+
 scs_log_t g_game_log { nullptr } ;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -46,19 +84,23 @@ bool   init_wheel () noexcept ;
 bool  reset_wheel () noexcept ;
 void deinit_wheel () noexcept ;
 
+void start_wheel_io () noexcept ;
+
+bool step_calibration   () noexcept ;
+bool check_wheel_online () noexcept ;
+bool reconnect_wheel    ( fffb::wheel & wheel ) noexcept ;
+
 bool update_leds ( float rpm ) noexcept ;
 bool update_ffb  ( fffb::telemetry_state const & telemetry ) noexcept ;
 
+bool start_ffb () noexcept ;
+void  stop_ffb () noexcept ;
+void  ffb_tick ( void * context ) noexcept ;
+
 SCSAPI_VOID telemetry_frame_start ( [[ maybe_unused ]] scs_event_t const event,                    void const * const event_info, [[ maybe_unused ]] scs_context_t const context ) ;
 SCSAPI_VOID telemetry_frame_end   ( [[ maybe_unused ]] scs_event_t const event, [[ maybe_unused ]] void const * const event_info, [[ maybe_unused ]] scs_context_t const context ) ;
 SCSAPI_VOID telemetry_pause       (                    scs_event_t const event, [[ maybe_unused ]] void const * const event_info, [[ maybe_unused ]] scs_context_t const context ) ;
 
-SCSAPI_VOID telemetry_store_orientation ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context ) ;
-SCSAPI_VOID telemetry_store_float       ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context ) ;
-SCSAPI_VOID telemetry_store_s32         ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context ) ;
-SCSAPI_VOID telemetry_store_u32         ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context ) ;
-SCSAPI_VOID telemetry_store_fvector     ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context ) ;
-
 SCSAPI_RESULT scs_telemetry_init     ( scs_u32_t const version, scs_telemetry_init_params_t const * const params ) ;
 SCSAPI_VOID   scs_telemetry_shutdown (                                                                           ) ;
 
@@ -67,16 +109,144 @@ void __attribute__(( destructor )) unload () ;
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
+// only arms calibration, the scheduler thread runs it so the game loader isn't blocked.
+// without a wheel the wheel starts out offline and the monitor brings it up once one is plugged in
 bool init_wheel () noexcept
 {
-        if( !g_simulator.wheel_ref().calibrate() )
+        g_wheel_inited = true ;
+
+        g_wheel_ready.store( false, std::memory_order_release ) ;
+
+        // started before discovery, a wheel plugged in after the game started is picked up from here
+        g_monitor_generation = g_monitor.generation() ;
+        g_reconnect_backoff  = 0 ;
+        g_reconnect_at       = 0 ;
+
+        bool const monitoring = g_monitor.start( FFFB_WHEEL_USAGE_PAGE, FFFB_WHEEL_USAGE, fffb::Logitech_VendorID ) ;
+
+        if( !monitoring )
+        {
+                FFFB_F_WARN_S( "scs::init_wheel", "failed starting device monitor, wheel won't be reacquired after a disconnect" ) ;
+        }
+        if( !g_simulator.initialize_wheel() )
+        {
+                if( !monitoring )
+                {
+                        g_game_log( SCS_LOG_TYPE_error, "fffb::error : no wheel to calibrate!" ) ;
+                        FFFB_F_ERR_S( "scs::init_wheel", "no wheel to calibrate!" ) ;
+                        return false ;
+                }
+                g_game_log( SCS_LOG_TYPE_warning, "fffb::warning : no wheel found, waiting for one to be plugged in" ) ;
+                FFFB_F_WARN_S( "scs::init_wheel", "no wheel found, waiting for one to be plugged in" ) ;
+
+                g_simulator.wheel_ref().mark_offline() ;
+                return true ;
+        }
+        start_wheel_io() ;
+
+        if( !g_simulator.wheel_ref().writer().running() )
+        {
+                g_game_log( SCS_LOG_TYPE_warning, "fffb::warning : failed starting writer thread, writing reports synchronously" ) ;
+        }
+        g_simulator.wheel_ref().begin_calibration() ;
+
+        return true ;
+}
+
+// writer and input reader of a wheel brought up for the first time, both are resumed by the wheel itself after that
+void start_wheel_io () noexcept
+{
+        if( !g_simulator.wheel_ref().start_writer() )
+        {
+                FFFB_F_WARN_S( "scs::start_wheel_io", "failed starting writer thread, writing reports synchronously" ) ;
+        }
+        if( !g_simulator.wheel_ref().start_input() )
+        {
+                FFFB_F_WARN_S( "scs::start_wheel_io", "failed starting input reader, wheel position won't be available" ) ;
+        }
+}
+
+// runs on the scheduler thread, which owns reconnecting: the wheel's reader and writer are stopped before its session is touched
+bool reconnect_wheel ( fffb::wheel & wheel ) noexcept
+{
+        if( !wheel.reconnect() )
+        {
+                g_reconnect_backoff = g_reconnect_backoff ? g_reconnect_backoff * 2 : reconnect_backoff_min ;
+
+                if( g_reconnect_backoff > reconnect_backoff_max ) g_reconnect_backoff = reconnect_backoff_max ;
+
+                g_reconnect_at      = fffb::monotonic_now() + g_reconnect_backoff ;
+
+                FFFB_F_WARN_S( "scs::reconnect_wheel", "wheel didn't come back, retrying in %llu ms", g_reconnect_backoff / 1000000 ) ;
+                return false ;
+        }
+        g_reconnect_backoff = 0 ;
+
+        // effects were forgotten with the cache, the next refresh downloads them again
+        g_ffb_stopped = true ;
+
+        // first time this wheel is seen, or it left halfway through calibrating
+        if( !g_wheel_ready.load( std::memory_order_relaxed ) )
+        {
+                start_wheel_io() ;
+                wheel.begin_calibration() ;
+        }
+        return true ;
+}
+
+// runs on the scheduler thread, only does work when the monitor saw a device arrive or leave, a write failed
+// or a wheel that's plugged in is still waiting for its retry
+bool check_wheel_online () noexcept
+{
+        fffb::wheel & wheel = g_simulator.wheel_ref() ;
+
+        uti::u64_t const generation = g_monitor.generation() ;
+
+        if( generation == g_monitor_generation )
+        {
+                if( wheel.online() && wheel.session_lost() )
+                {
+                        FFFB_F_WARN_S( "scs::check_wheel_online", "wheel session lost, reconnecting" ) ;
+                        reconnect_wheel( wheel ) ;
+                }
+                else if( !wheel.online() && g_monitor.online() && fffb::monotonic_now() >= g_reconnect_at )
+                {
+                        reconnect_wheel( wheel ) ;
+                }
+                return wheel.online() ;
+        }
+        g_monitor_generation = generation ;
+
+        // a device arriving or leaving starts the retries over
+        g_reconnect_backoff = 0 ;
+
+        if( !g_monitor.online() )
         {
-                g_game_log( SCS_LOG_TYPE_error, "fffb::error : wheel calibration failed!" ) ;
-                FFFB_F_ERR_S( "scs::init_wheel", "wheel calibration failed!" ) ;
+                wheel.mark_offline() ;
                 return false ;
         }
-        g_game_log( SCS_LOG_TYPE_message, "fffb::info : wheel calibration successful" ) ;
-        FFFB_F_INFO_S( "scs::init_wheel", "wheel calibration successful" ) ;
+        if( !wheel.online() || wheel.session_lost() ) reconnect_wheel( wheel ) ;
+
+        return wheel.online() ;
+}
+
+// runs on the scheduler thread, returns true once the wheel is ready for force feedback
+bool step_calibration () noexcept
+{
+        switch( g_simulator.wheel_ref().step_calibration( fffb::monotonic_now() ) )
+        {
+                case fffb::calibration_state::done:
+                        FFFB_F_INFO_S( "scs::step_calibration", "wheel calibration successful" ) ;
+                        break ;
+                case fffb::calibration_state::failed:
+                        FFFB_F_ERR_S( "scs::step_calibration", "wheel calibration failed, continuing without it" ) ;
+                        break ;
+                default:
+                        return false ;
+        }
+        g_ffb_stopped = true ;
+        g_wheel_ready.store( true, std::memory_order_release ) ;
+
         return true ;
 }
 
@@ -111,24 +281,114 @@ bool reset_wheel () noexcept
 
 bool update_ffb ( fffb::telemetry_state const & telemetry ) noexcept
 {
+        FFFB_NO_ALLOC_SCOPE( "scs::update_ffb" ) ;
+
         if( !g_simulator.wheel_ref() ) return false ;
 
-        static uti::i32_t ffb_rate       { 4 } ;
-        static uti::i32_t ffb_rate_count { 4 } ;
+        g_simulator.update_forces( telemetry ) ;
+
+        if( g_simulator.leds_due() ) update_leds( telemetry.rpm ) ;
 
-        --ffb_rate_count ;
+        return true ;
+}
+
+bool start_ffb () noexcept
+{
+        g_ffb_stopped = true ;
 
-        if( ffb_rate_count == 0 )
+#ifdef FFFB_STREAMING
+        return g_scheduler.start( FFFB_STREAM_RATE_HZ, ffb_tick, nullptr ) ;
+#else
+        return g_scheduler.start( FFFB_FFB_RATE_HZ, ffb_tick, nullptr ) ;
+#endif // FFFB_STREAMING
+}
+
+void stop_ffb () noexcept
+{
+        if( !g_scheduler.running() ) return ;
+
+        g_scheduler.stop() ;
+        g_scheduler.log_stats( "scs::stop_ffb" ) ;
+        g_simulator.rates().log_stats( "scs::stop_ffb" ) ;
+        g_simulator.mixer().log_stats( "scs::stop_ffb" ) ;
+}
+
+// runs on the scheduler thread, which is the only producer of wheel reports while it's running
+void ffb_tick ( [[ maybe_unused ]] void * context ) noexcept
+{
+        if( !check_wheel_online() )
+        {
+                return ;
+        }
+        if( !g_wheel_ready.load( std::memory_order_relaxed ) && !step_calibration() )
+        {
+                return ;
+        }
+        if( g_telemetry_paused.load( std::memory_order_acquire ) )
+        {
+                if( !g_ffb_stopped )
+                {
+                        reset_wheel() ;
+                        g_ffb_stopped = true ;
+                }
+                return ;
+        }
+        // the wheel was reset, recalibrated or reconnected since the last tick, nothing cached can be trusted
+        if( g_ffb_stopped ) g_simulator.invalidate() ;
+
+        g_ffb_stopped = false ;
+
+        // read before the load, a newer snapshot than the generation only makes us keep its bits for one more tick
+        uti::u64_t const generation = g_telemetry_snapshot.generation() ;
+
+        fffb::telemetry_state telemetry = g_telemetry_snapshot.load() ;
+
+        // the scheduler outruns the game, a snapshot's dirty bits only count the first time it's seen
+        if( generation == g_dirty_consumed.load( std::memory_order_relaxed ) )
+        {
+                telemetry.dirty = 0 ;
+        }
+        else
         {
-                g_simulator.update_forces( telemetry ) ;
-                update_leds( telemetry.rpm ) ;
+                g_dirty_consumed.store( generation, std::memory_order_release ) ;
+        }
+
+#ifdef FFFB_RECORDER
+        g_simulator.wheel_ref().clear_tap() ;
+#endif // FFFB_RECORDER
 
-                ffb_rate_count = ffb_rate ;
+        if( !update_ffb( telemetry ) )
+        {
+                FFFB_F_ERR_S( "scs::ffb_tick", "failed updating force feedback!" ) ;
         }
-        return true ;
+#ifdef FFFB_RECORDER
+        g_recorder.record( telemetry, g_simulator.wheel_ref() ) ;
+#endif // FFFB_RECORDER
 }
 
-void deinit_wheel () noexcept {}
+void deinit_wheel () noexcept
+{
+        if( !g_wheel_inited ) return ;
+
+        g_wheel_inited = false ;
+
+        stop_ffb() ;
+        g_monitor.stop() ;
+
+#ifdef FFFB_RECORDER
+        g_recorder.close() ;
+#endif // FFFB_RECORDER
+
+        g_wheel_ready.store( false, std::memory_order_release ) ;
+
+        if( !g_simulator.wheel_ref() ) return ;
+
+        g_simulator.wheel_ref().stop_input () ;
+        g_simulator.wheel_ref().stop_writer() ;
+        g_simulator.wheel_ref().stop_forces() ;
+        g_simulator.wheel_ref().enable_autocenter() ;
+        g_simulator.wheel_ref().close_session() ;
+}
 
 
 SCSAPI_VOID telemetry_frame_start ( [[ maybe_unused ]] scs_event_t const event, void const * const event_info, [[ maybe_unused ]] scs_context_t const context )
@@ -153,24 +413,31 @@ SCSAPI_VOID telemetry_frame_start ( [[ maybe_unused ]] scs_event_t const event,
 
 SCSAPI_VOID telemetry_frame_end ( [[ maybe_unused ]] scs_event_t const event, [[ maybe_unused ]] void const * const event_info, [[ maybe_unused ]] scs_context_t const context )
 {
-        if( g_telemetry_paused )
+        if( g_dirty_consumed.load( std::memory_order_acquire ) == g_dirty_published )
         {
-                return ;
+                g_pending_dirty = 0 ;
         }
-        if( !update_ffb( g_telemetry_state ) )
+        g_pending_dirty |= g_telemetry_state.dirty ;
+
+        if( !g_telemetry_paused.load( std::memory_order_relaxed ) && g_wheel_ready.load( std::memory_order_relaxed ) )
         {
-                g_game_log( SCS_LOG_TYPE_error, "fffb::error : failed updating force feedback!" ) ;
-                FFFB_F_ERR_S( "scs::telemetry_frame_end", "failed updating force feedback!" ) ;
+                g_telemetry_state.dirty = g_pending_dirty ;
+                g_telemetry_snapshot.store( g_telemetry_state ) ;
+                g_dirty_published = g_telemetry_snapshot.generation() ;
         }
+        // channel callbacks of the next frame start from a clean slate
+        g_telemetry_state.dirty = 0 ;
 }
 
 SCSAPI_VOID telemetry_pause ( scs_event_t const event, [[ maybe_unused ]] void const * const event_info, [[ maybe_unused ]] scs_context_t const context )
 {
-        g_telemetry_paused = ( event == SCS_TELEMETRY_EVENT_paused ) ;
+        bool const paused = ( event == SCS_TELEMETRY_EVENT_paused ) ;
+
+        // the scheduler notices the transition and resets the wheel from its own thread
+        g_telemetry_paused.store( paused, std::memory_order_release ) ;
 
-        if( g_telemetry_paused )
+        if( paused )
         {
-                reset_wheel() ;
                 g_game_log( SCS_LOG_TYPE_message, "fffb::info : telemetry paused, force feedback stopped" ) ;
                 FFFB_F_INFO_S( "scs::telemetry_pause", "telemetry paused, force feedback stopped" ) ;
         }
@@ -181,57 +448,6 @@ SCSAPI_VOID telemetry_pause ( scs_event_t const event, [[ maybe_unused ]] void c
         }
 }
 
-SCSAPI_VOID telemetry_store_orientation ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context )
-{
-        assert( context ) ;
-
-        fffb::telemetry_state * const state = static_cast< fffb::telemetry_state * >( context ) ;
-
-        if( !value )
-        {
-                state->orientation_available = false ;
-                return ;
-        }
-        assert( value ) ;
-        assert( value->type == SCS_VALUE_TYPE_euler ) ;
-        state->orientation_available = true ;
-        state->heading = value->value_euler.heading * 360.0f ;
-        state->  pitch = value->value_euler.  pitch * 360.0f ;
-        state->   roll = value->value_euler.   roll * 360.0f ;
-}
-
-SCSAPI_VOID telemetry_store_float ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context )
-{
-        assert( value ) ;
-        assert( value->type == SCS_VALUE_TYPE_float ) ;
-        assert( context ) ;
-        *static_cast< float * >( context ) = value->value_float.value ;
-}
-
-SCSAPI_VOID telemetry_store_s32 ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context )
-{
-        assert( value ) ;
-        assert( value->type == SCS_VALUE_TYPE_s32 ) ;
-        assert( context ) ;
-        *static_cast< int * >( context ) = value->value_s32.value ;
-}
-
-SCSAPI_VOID telemetry_store_u32 ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context )
-{
-        assert( value ) ;
-        assert( value->type == SCS_VALUE_TYPE_u32 ) ;
-        assert( context ) ;
-        *static_cast< int * >( context ) = value->value_u32.value ;
-}
-
-SCSAPI_VOID telemetry_store_fvector ( [[ maybe_unused ]] scs_string_t const name, [[ maybe_unused ]] scs_u32_t const index, scs_value_t const * const value, scs_context_t const context )
-{
-        assert( value ) ;
-        assert( value->type == SCS_VALUE_TYPE_fvector ) ;
-        assert( context ) ;
-        *static_cast< float * >( context ) = value->value_fvector.x ;
-}
-
 SCSAPI_RESULT scs_telemetry_init ( scs_u32_t const version, scs_telemetry_init_params_t const * const params )
 {
         if( version != SCS_TELEMETRY_VERSION_1_01 )
@@ -242,6 +458,10 @@ SCSAPI_RESULT scs_telemetry_init ( scs_u32_t const version, scs_telemetry_init_p
 
         g_game_log = version_params->common.log ;
 
+        if( !fffb::g_logger.start() )
+        {
+                g_game_log( SCS_LOG_TYPE_warning, "fffb::warning : failed to start logger thread, logging synchronously" ) ;
+        }
         g_game_log( SCS_LOG_TYPE_message, "fffb::info : version " FFFB_VERSION " starting initialization..." ) ;
         FFFB_F_INFO_S( "scs::scs_telemetry_init", "version " FFFB_VERSION " starting initialization..." ) ;
 
@@ -304,24 +524,13 @@ SCSAPI_RESULT scs_telemetry_init ( scs_u32_t const version, scs_telemetry_init_p
         g_game_log( SCS_LOG_TYPE_message, "fffb::info : registering to channels..." ) ;
         FFFB_F_INFO_S( "scs::scs_telemetry_init", "registering to channels..." ) ;
 
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_world_placement, SCS_U32_NIL, SCS_VALUE_TYPE_euler, SCS_TELEMETRY_CHANNEL_FLAG_no_value, telemetry_store_orientation, &g_telemetry_state       ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_speed          , SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none    , telemetry_store_float      , &g_telemetry_state.speed ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_engine_rpm     , SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none    , telemetry_store_float      , &g_telemetry_state.rpm   ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_engine_gear    , SCS_U32_NIL, SCS_VALUE_TYPE_s32  , SCS_TELEMETRY_CHANNEL_FLAG_none    , telemetry_store_s32        , &g_telemetry_state.gear  ) ;
-
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_effective_steering, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &g_telemetry_state.steering  ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_effective_throttle, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &g_telemetry_state.throttle  ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_effective_brake   , SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &g_telemetry_state.brake     ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_effective_clutch  , SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &g_telemetry_state.clutch    ) ;
-
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_wheel_substance, 0, SCS_VALUE_TYPE_u32, SCS_TELEMETRY_CHANNEL_FLAG_no_value, telemetry_store_u32, &g_telemetry_state.substance_l ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_wheel_substance, 1, SCS_VALUE_TYPE_u32, SCS_TELEMETRY_CHANNEL_FLAG_no_value, telemetry_store_u32, &g_telemetry_state.substance_r ) ;
-
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_local_linear_acceleration, SCS_U32_NIL, SCS_VALUE_TYPE_fvector, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_fvector, &g_telemetry_state.lateral_accel ) ;
-
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_wheel_susp_deflection, 0, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &g_telemetry_state.suspension_deflection_l ) ;
-        version_params->register_for_channel( SCS_TELEMETRY_TRUCK_CHANNEL_wheel_susp_deflection, 1, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &g_telemetry_state.suspension_deflection_r ) ;
+        uti::ssize_t const registered = fffb::register_channels( version_params->register_for_channel, g_telemetry_state, g_channel_bindings ) ;
 
+        if( registered != fffb::telemetry_channel_count )
+        {
+                g_game_log( SCS_LOG_TYPE_warning, "fffb::warning : some telemetry channels are unavailable, forces relying on them stay neutral" ) ;
+                FFFB_F_WARN_S( "scs::scs_telemetry_init", "registered %ld of %ld telemetry channels", registered, fffb::telemetry_channel_count ) ;
+        }
         g_game_log( SCS_LOG_TYPE_message, "fffb::info : channel registration completed" ) ;
         FFFB_F_INFO_S( "scs::scs_telemetry_init", "channel registration completed" ) ;
 
@@ -333,14 +542,29 @@ SCSAPI_RESULT scs_telemetry_init ( scs_u32_t const version, scs_telemetry_init_p
                 FFFB_F_ERR_S( "scs::scs_telemetry_init", "failed to initialize wheel!" ) ;
                 return SCS_RESULT_generic_error ;
         }
-        g_game_log( SCS_LOG_TYPE_message, "fffb::info : wheel initialization successful" ) ;
-        FFFB_F_INFO_S( "scs::scs_telemetry_init", "wheel initialization successful" ) ;
+        g_game_log( SCS_LOG_TYPE_message, "fffb::info : wheel initialization started, calibrating in the background" ) ;
+        FFFB_F_INFO_S( "scs::scs_telemetry_init", "wheel initialization started, calibrating in the background" ) ;
 
         memset( &g_telemetry_state, 0, sizeof( g_telemetry_state ) ) ;
+        g_telemetry_snapshot.store( g_telemetry_state ) ;
         g_last_timestamp = static_cast< scs_timestamp_t >( -1 ) ;
 
-        g_telemetry_paused = true ;
+        g_telemetry_paused.store( true, std::memory_order_release ) ;
+
+#ifdef FFFB_RECORDER
+        if( !g_recorder.open( FFFB_RECORDER_PATH, FFFB_RECORDER_FRAMES ) )
+        {
+                g_game_log( SCS_LOG_TYPE_warning, "fffb::warning : failed opening telemetry recording, continuing without it" ) ;
+                FFFB_F_WARN_S( "scs::scs_telemetry_init", "failed opening telemetry recording, continuing without it" ) ;
+        }
+#endif // FFFB_RECORDER
 
+        if( !start_ffb() )
+        {
+                g_game_log( SCS_LOG_TYPE_error, "fffb::error : failed to start force feedback scheduler!" ) ;
+                FFFB_F_ERR_S( "scs::scs_telemetry_init", "failed to start force feedback scheduler!" ) ;
+                return SCS_RESULT_generic_error ;
+        }
         g_game_log( SCS_LOG_TYPE_message, "fffb::info : successfully initialized" ) ;
         FFFB_F_INFO_S( "scs::scs_telemetry_init", "successfully initialized" ) ;
         return SCS_RESULT_ok ;
@@ -350,9 +574,13 @@ SCSAPI_VOID scs_telemetry_shutdown ()
 {
         g_game_log = nullptr ;
         deinit_wheel() ;
+
+        // drains whatever the shutdown logged before the game unloads us
+        fffb::g_logger.stop() ;
 }
 
 void __attribute__(( destructor )) unload ()
 {
         deinit_wheel() ;
+        fffb::g_logger.stop() ;
 }
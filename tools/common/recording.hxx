@@ -0,0 +1,85 @@
+//
+//
+//      fffb
+//      tools/common/recording.hxx
+//
+
+#pragma once
+
+#include <fffb/force/recorder.hxx>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace fffb::tools
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the live frames of a recorder ring, copied out and put back in recording order
+
+struct recording
+{
+        recorded_frame * frames { nullptr } ;
+        uti::ssize_t      count {       0 } ;
+        uti::ssize_t       torn {       0 } ;
+} ;
+
+[[ nodiscard ]] bool load_recording ( char const * path, recording & out ) noexcept
+{
+        FILE * file = fopen( path, "rb" ) ;
+
+        if( !file )
+        {
+                fprintf( stderr, "recording: failed opening '%s'\n", path ) ;
+                return false ;
+        }
+        recording_header header ;
+
+        if( fread( &header, sizeof( header ), 1, file ) != 1 || memcmp( header.magic, FFFB_RECORDER_MAGIC, sizeof( FFFB_RECORDER_MAGIC ) ) != 0 )
+        {
+                fprintf( stderr, "recording: '%s' is not an fffb recording\n", path ) ;
+                fclose( file ) ;
+                return false ;
+        }
+        if( header.version        != FFFB_RECORDER_VERSION     ||
+            header.header_size    != sizeof( recording_header ) ||
+            header.frame_size     != sizeof( recorded_frame   ) ||
+            header.telemetry_size != sizeof( telemetry_state  )  )
+        {
+                fprintf( stderr, "recording: '%s' was written by a different layout (version %u, frame %u bytes, telemetry %u bytes)\n",
+                         path, header.version, header.frame_size, header.telemetry_size ) ;
+                fclose( file ) ;
+                return false ;
+        }
+        out.frames = static_cast< recorded_frame * >( aligned_alloc( alignof( recorded_frame ), header.capacity * sizeof( recorded_frame ) ) ) ;
+
+        for( uti::u64_t i = 0; i < header.capacity; ++i )
+        {
+                recorded_frame & frame = out.frames[ out.count ] ;
+
+                if( fread( &frame, sizeof( frame ), 1, file ) != 1 ) break ;
+
+                // never written, or caught halfway through a rewrite
+                if( frame.sequence == 0 ) { if( i < header.written ) ++out.torn ; continue ; }
+
+                ++out.count ;
+        }
+        fclose( file ) ;
+
+        qsort( out.frames, out.count, sizeof( recorded_frame ), []( void const * lhs, void const * rhs )
+        {
+                uti::u64_t const l = static_cast< recorded_frame const * >( lhs )->sequence ;
+                uti::u64_t const r = static_cast< recorded_frame const * >( rhs )->sequence ;
+                return l < r ? -1 : l > r ? 1 : 0 ;
+        } ) ;
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb::tools
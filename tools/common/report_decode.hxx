@@ -0,0 +1,96 @@
+//
+//
+//      fffb
+//      tools/common/report_decode.hxx
+//
+
+#pragma once
+
+#include <fffb/hid/report.hxx>
+#include <fffb/joy/protocol.hxx>
+
+#include <cstdio>
+
+
+namespace fffb::tools
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// turns a logitech classic output report back into the command it encodes,
+// used by the tools to print and diff what the plugin sent
+
+constexpr char const * slot_name ( uti::u8_t const slots ) noexcept
+{
+        switch( slots )
+        {
+                case FFFB_FORCE_SLOT_CONSTANT  : return "constant"  ;
+                case FFFB_FORCE_SLOT_SPRING    : return "spring"    ;
+                case FFFB_FORCE_SLOT_DAMPER    : return "damper"    ;
+                case FFFB_FORCE_SLOT_TRAPEZOID : return "trapezoid" ;
+                case FFFB_FORCE_SLOT_AUTOCENTER: return "all"       ;
+                default                        : return "mask"      ;
+        }
+}
+
+constexpr char const * effect_name ( uti::u8_t const type ) noexcept
+{
+        switch( type )
+        {
+                case 0x00: return "constant"  ;
+                case 0x01: return "spring"    ;
+                case 0x02: return "damper"    ;
+                case 0x06: return "trapezoid" ;
+                default  : return "unknown"   ;
+        }
+}
+
+constexpr int describe_report ( report const & rep, char * out, uti::ssize_t cap ) noexcept
+{
+        uti::u8_t const cmd   = rep[ 0 ] & 0x0F ;
+        uti::u8_t const slots = rep[ 0 ] >> 4   ;
+
+        if( rep[ 0 ] == 0xF8 )
+        {
+                switch( rep[ 1 ] )
+                {
+                        case 0x12: return snprintf( out, cap, "led pattern=0x%.2x", rep[ 2 ] ) ;
+                        case 0x81: return snprintf( out, cap, "range degrees=%d", rep[ 2 ] | ( rep[ 3 ] << 8 ) ) ;
+                        case 0x09: return snprintf( out, cap, "mode switch %.2x %.2x", rep[ 2 ], rep[ 3 ] ) ;
+                        default  : return snprintf( out, cap, "extended 0x%.2x", rep[ 1 ] ) ;
+                }
+        }
+        switch( cmd )
+        {
+                case 0x00: [[ fallthrough ]] ;
+                case 0x0C:
+                {
+                        char const * verb = cmd == 0x00 ? "download" : "refresh" ;
+
+                        switch( rep[ 1 ] )
+                        {
+                                case 0x00: return snprintf( out, cap, "%s %s amplitude=%d", verb, slot_name( slots ), rep[ 2 ] ) ;
+                                case 0x01: return snprintf( out, cap, "%s %s dead=%d-%d slope=%d/%d invert=%d/%d amplitude=%d", verb, slot_name( slots ),
+                                                            rep[ 2 ], rep[ 3 ], rep[ 4 ] & 0x0F, rep[ 4 ] >> 4, rep[ 5 ] & 0x0F, rep[ 5 ] >> 4, rep[ 6 ] ) ;
+                                case 0x02: return snprintf( out, cap, "%s %s slope=%d/%d invert=%d/%d", verb, slot_name( slots ),
+                                                            rep[ 2 ], rep[ 4 ], rep[ 3 ], rep[ 5 ] ) ;
+                                case 0x06: return snprintf( out, cap, "%s %s amplitude=%d-%d t=%d/%d step=%d/%d", verb, slot_name( slots ),
+                                                            rep[ 3 ], rep[ 2 ], rep[ 4 ], rep[ 5 ], rep[ 6 ] >> 4, rep[ 6 ] & 0x0F ) ;
+                                default  : return snprintf( out, cap, "%s %s %s", verb, slot_name( slots ), effect_name( rep[ 1 ] ) ) ;
+                        }
+                }
+                case 0x02: return snprintf( out, cap, "play %s (0x%x)", slot_name( slots ), slots ) ;
+                case 0x03: return snprintf( out, cap, "stop %s (0x%x)", slot_name( slots ), slots ) ;
+                case 0x04: return snprintf( out, cap, "autocenter on (0x%x)" , slots ) ;
+                case 0x05: return snprintf( out, cap, "autocenter off (0x%x)", slots ) ;
+                case 0x0E: return snprintf( out, cap, "autocenter set slope=%d/%d amplitude=%d", rep[ 2 ], rep[ 3 ], rep[ 4 ] ) ;
+                default  : return snprintf( out, cap, "unknown %.2x %.2x %.2x %.2x %.2x %.2x %.2x %.2x",
+                                            rep[ 0 ], rep[ 1 ], rep[ 2 ], rep[ 3 ], rep[ 4 ], rep[ 5 ], rep[ 6 ], rep[ 7 ] ) ;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb::tools
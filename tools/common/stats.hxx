@@ -0,0 +1,68 @@
+//
+//
+//      fffb
+//      tools/common/stats.hxx
+//
+
+#pragma once
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace fffb::tools
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct latency_summary
+{
+        uti::ssize_t  count ;
+        nanoseconds_t   min ;
+        nanoseconds_t   p50 ;
+        nanoseconds_t   p90 ;
+        nanoseconds_t   p99 ;
+        nanoseconds_t   max ;
+        nanoseconds_t  mean ;
+} ;
+
+// sorts the samples in place
+constexpr latency_summary summarize ( nanoseconds_t * samples, uti::ssize_t count ) noexcept
+{
+        if( count <= 0 ) return {} ;
+
+        qsort( samples, count, sizeof( nanoseconds_t ), []( void const * lhs, void const * rhs )
+        {
+                nanoseconds_t const l = *static_cast< nanoseconds_t const * >( lhs ) ;
+                nanoseconds_t const r = *static_cast< nanoseconds_t const * >( rhs ) ;
+                return l < r ? -1 : l > r ? 1 : 0 ;
+        } ) ;
+
+        nanoseconds_t sum { 0 } ;
+        for( uti::ssize_t i = 0; i < count; ++i ) sum += samples[ i ] ;
+
+        auto at = [ & ]( uti::ssize_t const percent ) { return samples[ ( count - 1 ) * percent / 100 ] ; } ;
+
+        return { count, samples[ 0 ], at( 50 ), at( 90 ), at( 99 ), samples[ count - 1 ], sum / count } ;
+}
+
+constexpr void print_summary ( FILE * out, char const * label, latency_summary const & s ) noexcept
+{
+        fprintf( out, "%-20s n=%-8ld min=%8.2fus p50=%8.2fus p90=%8.2fus p99=%8.2fus max=%8.2fus mean=%8.2fus\n",
+                 label, static_cast< long >( s.count ),
+                 s.min / 1000.0, s.p50 / 1000.0, s.p90 / 1000.0, s.p99 / 1000.0, s.max / 1000.0, s.mean / 1000.0 ) ;
+}
+
+constexpr double per_second ( uti::u64_t const events, nanoseconds_t const elapsed ) noexcept
+{
+        return elapsed == 0 ? 0.0 : static_cast< double >( events ) * ns_per_sec / static_cast< double >( elapsed ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb::tools
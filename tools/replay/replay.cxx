@@ -0,0 +1,392 @@
+//
+//
+//      fffb
+//      tools/replay/replay.cxx
+//
+
+// feeds recorded or synthetic telemetry through simulator::update_forces as fast as it goes,
+// on the null hid backend so no wheel is involved. the first pass captures every report the wheel
+// emits, later passes run against a sink that drops them and only measure.
+//
+//      fffb_replay ( --recording file.rec | --synthetic frames ) [--iterations n] [--golden file] [--write-golden file] [--dump]
+//
+// --golden compares the captured stream byte for byte against an earlier --write-golden and exits
+// non-zero on any difference, printing the first frames that changed as decoded commands
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/hid/device.hxx>
+#include <fffb/force/simulator.hxx>
+#include <fffb/force/scheduler.hxx>
+
+#include <common/recording.hxx>
+#include <common/report_decode.hxx>
+#include <common/stats.hxx>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef FFFB_HID_BACKEND_NULL
+#error "fffb_replay: build against the null hid backend"
+#endif
+
+#define FFFB_GOLDEN_MAGIC      "FFFBGLD"
+#define FFFB_GOLDEN_SHOW_DIFFS 10
+
+
+namespace fffb::tools
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct captured_report
+{
+        uti::u32_t frame ;
+        uti::u8_t  data [ FFFB_REPORT_MAX_LEN ] ;
+} ;
+
+struct capture
+{
+        captured_report * reports  { nullptr } ;
+        uti::ssize_t      count    {       0 } ;
+        uti::ssize_t      capacity {       0 } ;
+        uti::u32_t        frame    {       0 } ;
+        uti::ssize_t      overflow {       0 } ;
+} ;
+
+void capture_sink ( void * context, report const & rep ) noexcept
+{
+        capture * cap = static_cast< capture * >( context ) ;
+
+        if( cap->count == cap->capacity ) { ++cap->overflow ; return ; }
+
+        captured_report & out = cap->reports[ cap->count++ ] ;
+
+        out.frame = cap->frame ;
+        memcpy( out.data, rep.data, FFFB_REPORT_MAX_LEN ) ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the same gentle drive the mock host uses, plus a gravel patch to exercise the trapezoid
+[[ nodiscard ]] telemetry_state synthetic_frame ( uti::ssize_t const frame ) noexcept
+{
+        constexpr double tau  { 6.283185307179586 } ;
+        constexpr double rate { FFFB_FFB_RATE_HZ  } ;
+
+        double const t = frame / rate ;
+
+        telemetry_state state {} ;
+
+        state.                       timestamp = static_cast< timestamp_t >( t * 1e6 ) ;
+        state.         raw_rendering_timestamp = state.timestamp ;
+        state.        raw_simulation_timestamp = state.timestamp ;
+        state. raw_paused_simulation_timestamp = state.timestamp ;
+
+        state.speed    = static_cast< float >(   20.0 +  10.0 * sin( tau * t /  8.0 ) ) ;
+        state.rpm      = static_cast< float >( 1400.0 + 400.0 * sin( tau * t /  3.0 ) ) ;
+        state.gear     = 6 ;
+        state.steering = static_cast< float >(    0.3 * sin( tau * t /  4.0 ) ) ;
+        state.throttle = static_cast< float >(    0.5 +   0.2 * sin( tau * t /  5.0 ) ) ;
+        state.brake    = t - floor( t / 12.0 ) * 12.0 < 2.0 ? 0.6f : 0.0f ;
+        state.clutch   = 0.0f ;
+
+        state.lateral_accel = static_cast< float >( 2.0 * sin( tau * t / 4.0 ) ) ;
+
+        bool const gravel = t - floor( t / 20.0 ) * 20.0 > 15.0 ;
+
+        state.substance_l = gravel ? 3 : 0 ;
+        state.substance_r = gravel ? 3 : 0 ;
+
+        state.suspension_deflection_l = static_cast< float >( 0.02 * sin( tau * t * 1.5 ) ) ;
+        state.suspension_deflection_r = static_cast< float >( 0.02 * sin( tau * t * 1.7 ) ) ;
+
+        // every input moves every frame
+        state.dirty = ~uti::u64_t( 0 ) ;
+
+        return state ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// one pass over every frame with a fresh simulator, so every pass starts from the same wheel state
+[[ nodiscard ]] bool replay_pass ( telemetry_state const * frames, uti::ssize_t const count, capture * cap, nanoseconds_t * samples ) noexcept
+{
+        simulator sim ;
+
+        set_null_hid_sink( nullptr, nullptr ) ;
+
+        if( !sim.initialize_wheel() )
+        {
+                fprintf( stderr, "replay: failed initializing the null wheel\n" ) ;
+                return false ;
+        }
+        // the stream starts at the first frame, init and autocenter reports aren't part of it
+        if( cap ) set_null_hid_sink( capture_sink, cap ) ;
+
+        for( uti::ssize_t i = 0; i < count; ++i )
+        {
+                if( cap ) cap->frame = static_cast< uti::u32_t >( i ) ;
+
+                nanoseconds_t const start = monotonic_now() ;
+
+                sim.update_forces( frames[ i ] ) ;
+
+                samples[ i ] = monotonic_now() - start ;
+        }
+        // nor is what the wheel sends while shutting down
+        set_null_hid_sink( nullptr, nullptr ) ;
+
+        return true ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+[[ nodiscard ]] bool write_golden ( char const * path, capture const & cap ) noexcept
+{
+        FILE * file = fopen( path, "wb" ) ;
+
+        if( !file )
+        {
+                fprintf( stderr, "replay: failed creating golden file '%s'\n", path ) ;
+                return false ;
+        }
+        uti::u64_t const count = cap.count ;
+
+        bool const ok = fwrite( FFFB_GOLDEN_MAGIC, sizeof( FFFB_GOLDEN_MAGIC ), 1, file ) == 1
+                     && fwrite( &count, sizeof( count ), 1, file ) == 1
+                     && fwrite( cap.reports, sizeof( captured_report ), cap.count, file ) == static_cast< size_t >( cap.count ) ;
+        fclose( file ) ;
+
+        if( !ok ) fprintf( stderr, "replay: failed writing golden file '%s'\n", path ) ;
+        return ok ;
+}
+
+[[ nodiscard ]] bool load_golden ( char const * path, capture & out ) noexcept
+{
+        FILE * file = fopen( path, "rb" ) ;
+
+        if( !file )
+        {
+                fprintf( stderr, "replay: failed opening golden file '%s'\n", path ) ;
+                return false ;
+        }
+        char       magic [ sizeof( FFFB_GOLDEN_MAGIC ) ] ;
+        uti::u64_t count ;
+
+        if( fread( magic, sizeof( magic ), 1, file ) != 1 || memcmp( magic, FFFB_GOLDEN_MAGIC, sizeof( magic ) ) != 0 ||
+            fread( &count, sizeof( count ), 1, file ) != 1 )
+        {
+                fprintf( stderr, "replay: '%s' is not a golden report stream\n", path ) ;
+                fclose( file ) ;
+                return false ;
+        }
+        out.reports  = static_cast< captured_report * >( malloc( count * sizeof( captured_report ) + 1 ) ) ;
+        out.capacity = count ;
+        out.count    = fread( out.reports, sizeof( captured_report ), count, file ) ;
+
+        fclose( file ) ;
+
+        if( out.count != out.capacity )
+        {
+                fprintf( stderr, "replay: golden file '%s' is truncated\n", path ) ;
+                return false ;
+        }
+        return true ;
+}
+
+void print_frame_reports ( char const * label, capture const & cap, uti::ssize_t & cursor, uti::u32_t const frame ) noexcept
+{
+        char line [ 128 ] ;
+
+        for( ; cursor < cap.count && cap.reports[ cursor ].frame == frame; ++cursor )
+        {
+                report rep {} ;
+                memcpy( rep.data, cap.reports[ cursor ].data, FFFB_REPORT_MAX_LEN ) ;
+                describe_report( rep, line, sizeof( line ) ) ;
+
+                printf( "    %s %s\n", label, line ) ;
+        }
+}
+
+// walks both streams frame by frame, a frame differs when its reports differ in count or bytes
+[[ nodiscard ]] uti::ssize_t compare_golden ( capture const & expected, capture const & actual, uti::ssize_t const frames ) noexcept
+{
+        uti::ssize_t e { 0 } ;
+        uti::ssize_t a { 0 } ;
+        uti::ssize_t differing { 0 } ;
+
+        for( uti::u32_t frame = 0; frame < static_cast< uti::u32_t >( frames ); ++frame )
+        {
+                uti::ssize_t e_end = e ; while( e_end < expected.count && expected.reports[ e_end ].frame == frame ) ++e_end ;
+                uti::ssize_t a_end = a ; while( a_end <   actual.count &&   actual.reports[ a_end ].frame == frame ) ++a_end ;
+
+                bool const same = e_end - e == a_end - a
+                               && memcmp( expected.reports + e, actual.reports + a, ( e_end - e ) * sizeof( captured_report ) ) == 0 ;
+
+                if( !same && differing++ < FFFB_GOLDEN_SHOW_DIFFS )
+                {
+                        printf( "  frame %u:\n", frame ) ;
+                        print_frame_reports( "-", expected, e, frame ) ;
+                        print_frame_reports( "+",   actual, a, frame ) ;
+                }
+                e = e_end ;
+                a = a_end ;
+        }
+        return differing ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct replay_options
+{
+        char const *    recording { nullptr } ;
+        uti::ssize_t    synthetic {       0 } ;
+        uti::ssize_t   iterations {       5 } ;
+        char const *       golden { nullptr } ;
+        char const * write_golden { nullptr } ;
+        bool                 dump {   false } ;
+} ;
+
+[[ nodiscard ]] bool parse_options ( int argc, char ** argv, replay_options & opts ) noexcept
+{
+        for( int i = 1; i < argc; ++i )
+        {
+                bool const has_value = i + 1 < argc ;
+
+                if     ( strcmp( argv[ i ], "--recording"    ) == 0 && has_value ) opts.recording    =       argv[ ++i ]   ;
+                else if( strcmp( argv[ i ], "--synthetic"    ) == 0 && has_value ) opts.synthetic    = atol( argv[ ++i ] ) ;
+                else if( strcmp( argv[ i ], "--iterations"   ) == 0 && has_value ) opts.iterations   = atol( argv[ ++i ] ) ;
+                else if( strcmp( argv[ i ], "--golden"       ) == 0 && has_value ) opts.golden       =       argv[ ++i ]   ;
+                else if( strcmp( argv[ i ], "--write-golden" ) == 0 && has_value ) opts.write_golden =       argv[ ++i ]   ;
+                else if( strcmp( argv[ i ], "--dump"         ) == 0              ) opts.dump         = true ;
+                else return false ;
+        }
+        return ( opts.recording != nullptr ) != ( opts.synthetic > 0 ) && opts.iterations >= 1 ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb::tools
+
+
+int main ( int argc, char ** argv )
+{
+        using namespace fffb       ;
+        using namespace fffb::tools ;
+
+        replay_options opts ;
+
+        if( !parse_options( argc, argv, opts ) )
+        {
+                fprintf( stderr, "usage: %s ( --recording file.rec | --synthetic frames ) [--iterations n] [--golden file] [--write-golden file] [--dump]\n", argv[ 0 ] ) ;
+                return 1 ;
+        }
+        // telemetry is laid out contiguously up front so the timed loop only reads memory
+        telemetry_state * frames { nullptr } ;
+        uti::ssize_t      count  {       0 } ;
+
+        if( opts.recording )
+        {
+                recording rec ;
+
+                if( !load_recording( opts.recording, rec ) ) return 1 ;
+
+                if( rec.torn > 0 ) fprintf( stderr, "replay: skipped %ld torn frames\n", static_cast< long >( rec.torn ) ) ;
+
+                count  = rec.count ;
+                frames = static_cast< telemetry_state * >( aligned_alloc( alignof( telemetry_state ), ( count + 1 ) * sizeof( telemetry_state ) ) ) ;
+
+                for( uti::ssize_t i = 0; i < count; ++i ) frames[ i ] = rec.frames[ i ].telemetry ;
+
+                free( rec.frames ) ;
+        }
+        else
+        {
+                count  = opts.synthetic ;
+                frames = static_cast< telemetry_state * >( aligned_alloc( alignof( telemetry_state ), count * sizeof( telemetry_state ) ) ) ;
+
+                for( uti::ssize_t i = 0; i < count; ++i ) frames[ i ] = synthetic_frame( i ) ;
+        }
+        if( count == 0 )
+        {
+                fprintf( stderr, "replay: nothing to replay\n" ) ;
+                return 1 ;
+        }
+        capture cap ;
+        cap.capacity = count * FFFB_PROTOCOL_MAX_TICK_REPORTS ;
+        cap.reports  = static_cast< captured_report * >( malloc( cap.capacity * sizeof( captured_report ) ) ) ;
+
+        nanoseconds_t * capture_samples = static_cast< nanoseconds_t * >( malloc( count * sizeof( nanoseconds_t ) ) ) ;
+        nanoseconds_t *    null_samples = static_cast< nanoseconds_t * >( malloc( count * ( opts.iterations - 1 ) * sizeof( nanoseconds_t ) + 1 ) ) ;
+
+        nanoseconds_t const capture_start = monotonic_now() ;
+
+        if( !replay_pass( frames, count, &cap, capture_samples ) ) return 1 ;
+
+        nanoseconds_t const capture_elapsed = monotonic_now() - capture_start ;
+        nanoseconds_t const    null_start   = monotonic_now() ;
+
+        for( uti::ssize_t pass = 1; pass < opts.iterations; ++pass )
+        {
+                if( !replay_pass( frames, count, nullptr, null_samples + ( pass - 1 ) * count ) ) return 1 ;
+        }
+        nanoseconds_t const null_elapsed = monotonic_now() - null_start ;
+
+        if( cap.overflow > 0 ) fprintf( stderr, "replay: capture buffer overflowed by %ld reports\n", static_cast< long >( cap.overflow ) ) ;
+
+        if( opts.dump )
+        {
+                uti::ssize_t cursor { 0 } ;
+
+                for( uti::u32_t frame = 0; frame < static_cast< uti::u32_t >( count ); ++frame )
+                {
+                        if( cursor < cap.count && cap.reports[ cursor ].frame == frame ) printf( "frame %u:\n", frame ) ;
+                        print_frame_reports( " ", cap, cursor, frame ) ;
+                }
+        }
+        printf( "%ld frames, %ld reports (%.2f per frame)\n", static_cast< long >( count ), static_cast< long >( cap.count ),
+                static_cast< double >( cap.count ) / count ) ;
+
+        print_summary( stdout, "update (capture)", summarize( capture_samples, count ) ) ;
+        printf( "%-20s %.0f frames/s\n", "rate (capture)", per_second( count, capture_elapsed ) ) ;
+
+        if( opts.iterations > 1 )
+        {
+                print_summary( stdout, "update (null)", summarize( null_samples, count * ( opts.iterations - 1 ) ) ) ;
+                printf( "%-20s %.0f frames/s\n", "rate (null)", per_second( count * ( opts.iterations - 1 ), null_elapsed ) ) ;
+        }
+        int status { 0 } ;
+
+        if( opts.write_golden && !write_golden( opts.write_golden, cap ) ) status = 1 ;
+
+        if( opts.golden )
+        {
+                capture golden ;
+
+                if( !load_golden( opts.golden, golden ) )
+                {
+                        status = 1 ;
+                }
+                else
+                {
+                        uti::ssize_t const differing = compare_golden( golden, cap, count ) ;
+
+                        if( differing == 0 ) printf( "report stream matches %s\n", opts.golden ) ;
+                        else                 printf( "report stream differs from %s in %ld of %ld frames\n", opts.golden,
+                                                     static_cast< long >( differing ), static_cast< long >( count ) ) ;
+                        if( differing > 0 ) status = 2 ;
+                }
+                free( golden.reports ) ;
+        }
+        free( null_samples    ) ;
+        free( capture_samples ) ;
+        free( cap.reports     ) ;
+        free( frames          ) ;
+
+        return status ;
+}
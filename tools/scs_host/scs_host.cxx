@@ -0,0 +1,543 @@
+//
+//
+//      fffb
+//      tools/scs_host/scs_host.cxx
+//
+
+// stands in for ets2/ats: dlopens the plugin, hands it a fake telemetry init, records what it registers
+// and then drives frame_start / channels / frame_end at a fixed rate, timing every callback on the way.
+//
+//      fffb_scs_host <libfffb> [--rate hz] [--seconds s] [--warmup s] [--game eut2|ats] [--trace file.csv] [--quiet]
+//
+// channel values are synthetic unless --trace is given. a trace is a csv whose header names scs channels,
+// 'truck.wheel.substance[1]' for indexed ones, and every following row is one frame.
+// the plugin still wants a wheel, run this against a real one or against fffb_uhid_wheel
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+
+#include <common/stats.hxx>
+
+#include <scssdk_telemetry.h>
+#include <eurotrucks2/scssdk_eut2.h>
+#include <eurotrucks2/scssdk_telemetry_eut2.h>
+#include <amtrucks/scssdk_ats.h>
+#include <amtrucks/scssdk_telemetry_ats.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dlfcn.h>
+
+#define FFFB_HOST_MAX_EVENTS   8
+#define FFFB_HOST_MAX_CHANNELS 64
+#define FFFB_HOST_MAX_COLUMNS  FFFB_HOST_MAX_CHANNELS
+#define FFFB_HOST_NAME_LEN     96
+#define FFFB_HOST_LINE_LEN     4096
+
+
+namespace fffb::tools
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct registered_event
+{
+        scs_event_t                      event ;
+        scs_telemetry_event_callback_t callback ;
+        scs_context_t                   context ;
+} ;
+
+struct registered_channel
+{
+        char                                name [ FFFB_HOST_NAME_LEN ] ;
+        scs_u32_t                          index ;
+        scs_value_type_t                    type ;
+        scs_u32_t                          flags ;
+        scs_telemetry_channel_callback_t callback ;
+        scs_context_t                    context ;
+
+        // column in the trace feeding this channel, -1 for synthetic values
+        int column ;
+
+        nanoseconds_t * samples ;
+} ;
+
+struct host_state
+{
+        registered_event     events [ FFFB_HOST_MAX_EVENTS   ] ;
+        registered_channel channels [ FFFB_HOST_MAX_CHANNELS ] ;
+
+        uti::ssize_t   event_count { 0 } ;
+        uti::ssize_t channel_count { 0 } ;
+
+        bool quiet { false } ;
+} ;
+
+static host_state g_host {} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+SCSAPI_VOID host_log ( scs_log_type_t const type, scs_string_t const message )
+{
+        if( g_host.quiet && type == SCS_LOG_TYPE_message ) return ;
+
+        char const * prefix = type == SCS_LOG_TYPE_error   ? "error"
+                            : type == SCS_LOG_TYPE_warning ? "warn "
+                            :                                "info " ;
+        fprintf( stderr, "[game %s] %s\n", prefix, message ) ;
+}
+
+SCSAPI_RESULT host_register_for_event ( scs_event_t const event, scs_telemetry_event_callback_t const callback, scs_context_t const context )
+{
+        if( !callback ) return SCS_RESULT_invalid_parameter ;
+
+        for( uti::ssize_t i = 0; i < g_host.event_count; ++i )
+        {
+                if( g_host.events[ i ].event == event ) return SCS_RESULT_already_registered ;
+        }
+        if( g_host.event_count == FFFB_HOST_MAX_EVENTS ) return SCS_RESULT_generic_error ;
+
+        g_host.events[ g_host.event_count++ ] = { event, callback, context } ;
+        return SCS_RESULT_ok ;
+}
+
+SCSAPI_RESULT host_unregister_from_event ( scs_event_t const event )
+{
+        for( uti::ssize_t i = 0; i < g_host.event_count; ++i )
+        {
+                if( g_host.events[ i ].event != event ) continue ;
+
+                g_host.events[ i ] = g_host.events[ --g_host.event_count ] ;
+                return SCS_RESULT_ok ;
+        }
+        return SCS_RESULT_not_found ;
+}
+
+SCSAPI_RESULT host_register_for_channel ( scs_string_t const name, scs_u32_t const index, scs_value_type_t const type, scs_u32_t const flags,
+                                          scs_telemetry_channel_callback_t const callback, scs_context_t const context )
+{
+        if( !name || !callback ) return SCS_RESULT_invalid_parameter ;
+
+        for( uti::ssize_t i = 0; i < g_host.channel_count; ++i )
+        {
+                registered_channel const & channel = g_host.channels[ i ] ;
+
+                if( channel.index == index && channel.type == type && strcmp( channel.name, name ) == 0 ) return SCS_RESULT_already_registered ;
+        }
+        if( g_host.channel_count == FFFB_HOST_MAX_CHANNELS ) return SCS_RESULT_generic_error ;
+
+        registered_channel & channel = g_host.channels[ g_host.channel_count++ ] ;
+
+        snprintf( channel.name, sizeof( channel.name ), "%s", name ) ;
+        channel.index    = index    ;
+        channel.type     = type     ;
+        channel.flags    = flags    ;
+        channel.callback = callback ;
+        channel.context  = context  ;
+        channel.column   = -1       ;
+        channel.samples  = nullptr  ;
+
+        return SCS_RESULT_ok ;
+}
+
+SCSAPI_RESULT host_unregister_from_channel ( scs_string_t const name, scs_u32_t const index, scs_value_type_t const type )
+{
+        for( uti::ssize_t i = 0; i < g_host.channel_count; ++i )
+        {
+                registered_channel & channel = g_host.channels[ i ] ;
+
+                if( channel.index != index || channel.type != type || strcmp( channel.name, name ) != 0 ) continue ;
+
+                free( channel.samples ) ;
+                channel = g_host.channels[ --g_host.channel_count ] ;
+                return SCS_RESULT_ok ;
+        }
+        return SCS_RESULT_not_found ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// rows of a recorded trace, loaded up front so file io never lands inside a measured frame
+
+struct trace
+{
+        char         columns [ FFFB_HOST_MAX_COLUMNS ][ FFFB_HOST_NAME_LEN ] ;
+        uti::ssize_t column_count { 0 } ;
+
+        double *     values  { nullptr } ;
+        uti::ssize_t rows    {       0 } ;
+} ;
+
+[[ nodiscard ]] bool load_trace ( char const * path, trace & out ) noexcept
+{
+        FILE * file = fopen( path, "r" ) ;
+
+        if( !file )
+        {
+                fprintf( stderr, "scs_host: failed opening trace '%s'\n", path ) ;
+                return false ;
+        }
+        static char line [ FFFB_HOST_LINE_LEN ] ;
+
+        if( !fgets( line, sizeof( line ), file ) )
+        {
+                fprintf( stderr, "scs_host: trace '%s' is empty\n", path ) ;
+                fclose( file ) ;
+                return false ;
+        }
+        for( char * tok = strtok( line, ",\r\n" ); tok && out.column_count < FFFB_HOST_MAX_COLUMNS; tok = strtok( nullptr, ",\r\n" ) )
+        {
+                while( *tok == ' ' ) ++tok ;
+                snprintf( out.columns[ out.column_count++ ], FFFB_HOST_NAME_LEN, "%s", tok ) ;
+        }
+        uti::ssize_t capacity { 1024 } ;
+
+        out.values = static_cast< double * >( malloc( capacity * out.column_count * sizeof( double ) ) ) ;
+
+        while( fgets( line, sizeof( line ), file ) )
+        {
+                if( line[ 0 ] == '\n' || line[ 0 ] == '#' ) continue ;
+
+                if( out.rows == capacity )
+                {
+                        capacity *= 2 ;
+                        out.values = static_cast< double * >( realloc( out.values, capacity * out.column_count * sizeof( double ) ) ) ;
+                }
+                double * row = out.values + out.rows * out.column_count ;
+
+                char * cursor = line ;
+
+                for( uti::ssize_t col = 0; col < out.column_count; ++col )
+                {
+                        row[ col ] = strtod( cursor, &cursor ) ;
+
+                        if( *cursor == ',' ) ++cursor ;
+                }
+                ++out.rows ;
+        }
+        fclose( file ) ;
+
+        if( out.rows == 0 )
+        {
+                fprintf( stderr, "scs_host: trace '%s' has no frames\n", path ) ;
+                return false ;
+        }
+        return true ;
+}
+
+void bind_trace ( trace const & tr ) noexcept
+{
+        char key [ FFFB_HOST_NAME_LEN + 16 ] ;
+
+        for( uti::ssize_t i = 0; i < g_host.channel_count; ++i )
+        {
+                registered_channel & channel = g_host.channels[ i ] ;
+
+                if( channel.index == SCS_U32_NIL ) snprintf( key, sizeof( key ), "%s", channel.name ) ;
+                else                               snprintf( key, sizeof( key ), "%s[%u]", channel.name, channel.index ) ;
+
+                for( uti::ssize_t col = 0; col < tr.column_count; ++col )
+                {
+                        if( strcmp( tr.columns[ col ], key ) == 0 ) channel.column = static_cast< int >( col ) ;
+                }
+                if( channel.column < 0 ) fprintf( stderr, "scs_host: trace has no column for '%s', using synthetic values\n", key ) ;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a gentle drive: slow speed and rpm swells, steering back and forth, some body roll and suspension travel
+[[ nodiscard ]] double synthetic_value ( char const * name, double const t ) noexcept
+{
+        constexpr double tau { 6.283185307179586 } ;
+
+        if( strcmp( name, "truck.speed"                     ) == 0 ) return  20.0 +  10.0 * sin( tau * t /  8.0 ) ;
+        if( strcmp( name, "truck.engine.rpm"                ) == 0 ) return 1400.0 + 400.0 * sin( tau * t /  3.0 ) ;
+        if( strcmp( name, "truck.engine.gear"               ) == 0 ) return   6.0 ;
+        if( strcmp( name, "truck.effective.steering"        ) == 0 ) return   0.3 * sin( tau * t /  4.0 ) ;
+        if( strcmp( name, "truck.effective.throttle"        ) == 0 ) return   0.5 +   0.2 * sin( tau * t /  5.0 ) ;
+        if( strcmp( name, "truck.local.acceleration.linear" ) == 0 ) return   2.0 * sin( tau * t /  4.0 ) ;
+        if( strcmp( name, "truck.wheel.suspension.deflection" ) == 0 ) return 0.02 * sin( tau * t * 1.5 ) ;
+        if( strcmp( name, "truck.world.placement"           ) == 0 ) return   fmod( t / 60.0, 1.0 ) ;
+
+        return 0.0 ;
+}
+
+[[ nodiscard ]] scs_value_t make_value ( scs_value_type_t const type, double const v ) noexcept
+{
+        scs_value_t value {} ;
+        value.type = type ;
+
+        switch( type )
+        {
+                case SCS_VALUE_TYPE_bool   : value.value_bool   .value = v != 0.0 ? 1 : 0 ; break ;
+                case SCS_VALUE_TYPE_s32    : value.value_s32    .value = static_cast< scs_s32_t   >( v ) ; break ;
+                case SCS_VALUE_TYPE_u32    : value.value_u32    .value = static_cast< scs_u32_t   >( v ) ; break ;
+                case SCS_VALUE_TYPE_u64    : value.value_u64    .value = static_cast< scs_u64_t   >( v ) ; break ;
+                case SCS_VALUE_TYPE_s64    : value.value_s64    .value = static_cast< scs_s64_t   >( v ) ; break ;
+                case SCS_VALUE_TYPE_float  : value.value_float  .value = static_cast< scs_float_t >( v ) ; break ;
+                case SCS_VALUE_TYPE_double : value.value_double .value = v ; break ;
+                case SCS_VALUE_TYPE_fvector: value.value_fvector.x     = static_cast< scs_float_t >( v ) ; break ;
+                case SCS_VALUE_TYPE_dvector: value.value_dvector.x     = v ; break ;
+                case SCS_VALUE_TYPE_euler  : value.value_euler.heading = static_cast< scs_float_t >( v ) ; break ;
+                default: break ;
+        }
+        return value ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+[[ nodiscard ]] registered_event const * find_event ( scs_event_t const event ) noexcept
+{
+        for( uti::ssize_t i = 0; i < g_host.event_count; ++i )
+        {
+                if( g_host.events[ i ].event == event ) return &g_host.events[ i ] ;
+        }
+        return nullptr ;
+}
+
+nanoseconds_t fire_event ( scs_event_t const event, void const * info ) noexcept
+{
+        registered_event const * reg = find_event( event ) ;
+
+        if( !reg ) return 0 ;
+
+        nanoseconds_t const start = monotonic_now() ;
+        reg->callback( event, info, reg->context ) ;
+        return monotonic_now() - start ;
+}
+
+struct frame_samples
+{
+        nanoseconds_t * frame_start ;
+        nanoseconds_t * channels    ;
+        nanoseconds_t * frame_end   ;
+        nanoseconds_t * total       ;
+} ;
+
+// one game frame: frame_start, every registered channel, frame_end. timings land in slot unless it's negative
+void run_frame ( uti::ssize_t const frame, uti::ssize_t const rate_hz, trace const & tr, frame_samples const & samples, uti::ssize_t const slot ) noexcept
+{
+        double          const t   = static_cast< double >( frame ) / rate_hz ;
+        scs_timestamp_t const now = static_cast< scs_timestamp_t >( frame ) * 1000000 / rate_hz ;
+
+        scs_telemetry_frame_start_t info {} ;
+        info.flags                  = frame == 0 ? SCS_TELEMETRY_FRAME_START_FLAG_timer_restart : 0 ;
+        info.render_time            = now ;
+        info.simulation_time        = now ;
+        info.paused_simulation_time = now ;
+
+        nanoseconds_t const start = monotonic_now() ;
+
+        nanoseconds_t const frame_start = fire_event( SCS_TELEMETRY_EVENT_frame_start, &info ) ;
+        nanoseconds_t       channels    { 0 } ;
+
+        double const * row = tr.rows > 0 ? tr.values + ( frame % tr.rows ) * tr.column_count : nullptr ;
+
+        for( uti::ssize_t i = 0; i < g_host.channel_count; ++i )
+        {
+                registered_channel const & channel = g_host.channels[ i ] ;
+
+                double const v = row && channel.column >= 0 ? row[ channel.column ] : synthetic_value( channel.name, t ) ;
+
+                scs_value_t const value = make_value( channel.type, v ) ;
+
+                nanoseconds_t const before = monotonic_now() ;
+                channel.callback( channel.name, channel.index, &value, channel.context ) ;
+                nanoseconds_t const spent = monotonic_now() - before ;
+
+                channels += spent ;
+                if( slot >= 0 ) channel.samples[ slot ] = spent ;
+        }
+        nanoseconds_t const frame_end = fire_event( SCS_TELEMETRY_EVENT_frame_end, nullptr ) ;
+        nanoseconds_t const total     = monotonic_now() - start ;
+
+        if( slot < 0 ) return ;
+
+        samples.frame_start[ slot ] = frame_start ;
+        samples.channels   [ slot ] = channels    ;
+        samples.frame_end  [ slot ] = frame_end   ;
+        samples.total      [ slot ] = total       ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct host_options
+{
+        char const *    plugin { nullptr } ;
+        char const *     trace { nullptr } ;
+        char const *      game { SCS_GAME_ID_EUT2 } ;
+        uti::ssize_t   rate_hz { 60 } ;
+        double         seconds { 10.0 } ;
+        double          warmup {  5.0 } ;
+        bool             quiet { false } ;
+} ;
+
+[[ nodiscard ]] bool parse_options ( int argc, char ** argv, host_options & opts ) noexcept
+{
+        for( int i = 1; i < argc; ++i )
+        {
+                bool const has_value = i + 1 < argc ;
+
+                if     ( strcmp( argv[ i ], "--rate"    ) == 0 && has_value ) opts.rate_hz = atol( argv[ ++i ] ) ;
+                else if( strcmp( argv[ i ], "--seconds" ) == 0 && has_value ) opts.seconds = atof( argv[ ++i ] ) ;
+                else if( strcmp( argv[ i ], "--warmup"  ) == 0 && has_value ) opts.warmup  = atof( argv[ ++i ] ) ;
+                else if( strcmp( argv[ i ], "--game"    ) == 0 && has_value ) opts.game    =       argv[ ++i ]   ;
+                else if( strcmp( argv[ i ], "--trace"   ) == 0 && has_value ) opts.trace   =       argv[ ++i ]   ;
+                else if( strcmp( argv[ i ], "--quiet"   ) == 0              ) opts.quiet   = true ;
+                else if( argv[ i ][ 0 ] != '-' && !opts.plugin              ) opts.plugin  = argv[ i ] ;
+                else return false ;
+        }
+        return opts.plugin && opts.rate_hz >= 1 && opts.rate_hz <= 10000 && opts.seconds > 0.0 && opts.warmup >= 0.0 ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb::tools
+
+
+int main ( int argc, char ** argv )
+{
+        using namespace fffb       ;
+        using namespace fffb::tools ;
+
+        host_options opts ;
+
+        if( !parse_options( argc, argv, opts ) )
+        {
+                fprintf( stderr, "usage: %s <libfffb> [--rate hz] [--seconds s] [--warmup s] [--game eut2|ats] [--trace file.csv] [--quiet]\n", argv[ 0 ] ) ;
+                return 1 ;
+        }
+        g_host.quiet = opts.quiet ;
+
+        trace tr ;
+
+        if( opts.trace && !load_trace( opts.trace, tr ) ) return 1 ;
+
+        void * plugin = dlopen( opts.plugin, RTLD_NOW | RTLD_LOCAL ) ;
+
+        if( !plugin )
+        {
+                fprintf( stderr, "scs_host: %s\n", dlerror() ) ;
+                return 1 ;
+        }
+        using init_fn     = scs_result_t ( * )( scs_u32_t, scs_telemetry_init_params_t const * ) ;
+        using shutdown_fn = void         ( * )(                                                  ) ;
+
+        auto init     = reinterpret_cast<     init_fn >( dlsym( plugin, "scs_telemetry_init"     ) ) ;
+        auto shutdown = reinterpret_cast< shutdown_fn >( dlsym( plugin, "scs_telemetry_shutdown" ) ) ;
+
+        if( !init || !shutdown )
+        {
+                fprintf( stderr, "scs_host: '%s' doesn't export the telemetry entry points\n", opts.plugin ) ;
+                dlclose( plugin ) ;
+                return 1 ;
+        }
+        bool const ats = strcmp( opts.game, SCS_GAME_ID_ATS ) == 0 ;
+
+        scs_telemetry_init_params_v101_t params {} ;
+
+        params.common.game_name    = ats ? "American Truck Simulator (fffb host)" : "Euro Truck Simulator 2 (fffb host)" ;
+        params.common.game_id      = ats ? SCS_GAME_ID_ATS : SCS_GAME_ID_EUT2 ;
+        params.common.game_version = ats ? SCS_TELEMETRY_ATS_GAME_VERSION_CURRENT : SCS_TELEMETRY_EUT2_GAME_VERSION_CURRENT ;
+        params.common.log          = host_log ;
+
+        params.register_for_event      = host_register_for_event      ;
+        params.unregister_from_event   = host_unregister_from_event   ;
+        params.register_for_channel    = host_register_for_channel    ;
+        params.unregister_from_channel = host_unregister_from_channel ;
+
+        nanoseconds_t const init_start = monotonic_now() ;
+        scs_result_t  const result     = init( SCS_TELEMETRY_VERSION_1_01, &params ) ;
+        nanoseconds_t const init_time  = monotonic_now() - init_start ;
+
+        if( result != SCS_RESULT_ok )
+        {
+                fprintf( stderr, "scs_host: scs_telemetry_init failed with %d\n", result ) ;
+                dlclose( plugin ) ;
+                return 1 ;
+        }
+        printf( "plugin registered %ld events and %ld channels, init took %.2fms\n",
+                static_cast< long >( g_host.event_count ), static_cast< long >( g_host.channel_count ), init_time / 1e6 ) ;
+
+        if( opts.trace ) bind_trace( tr ) ;
+
+        uti::ssize_t const warmup_frames = static_cast< uti::ssize_t >( opts.warmup  * opts.rate_hz ) ;
+        uti::ssize_t const frames        = static_cast< uti::ssize_t >( opts.seconds * opts.rate_hz ) ;
+
+        frame_samples samples
+        {
+                static_cast< nanoseconds_t * >( malloc( frames * sizeof( nanoseconds_t ) ) ),
+                static_cast< nanoseconds_t * >( malloc( frames * sizeof( nanoseconds_t ) ) ),
+                static_cast< nanoseconds_t * >( malloc( frames * sizeof( nanoseconds_t ) ) ),
+                static_cast< nanoseconds_t * >( malloc( frames * sizeof( nanoseconds_t ) ) ),
+        } ;
+        for( uti::ssize_t i = 0; i < g_host.channel_count; ++i )
+        {
+                g_host.channels[ i ].samples = static_cast< nanoseconds_t * >( malloc( frames * sizeof( nanoseconds_t ) ) ) ;
+        }
+        nanoseconds_t const period = ns_per_sec / opts.rate_hz ;
+
+        fire_event( SCS_TELEMETRY_EVENT_started, nullptr ) ;
+
+        // warmup frames let the wheel calibrate before anything is measured
+        nanoseconds_t deadline = monotonic_now() ;
+
+        for( uti::ssize_t frame = 0; frame < warmup_frames; ++frame )
+        {
+                run_frame( frame, opts.rate_hz, tr, samples, -1 ) ;
+                sleep_until( deadline += period ) ;
+        }
+        uti::ssize_t        late  { 0 } ;
+        nanoseconds_t const start = monotonic_now() ;
+
+        deadline = start ;
+
+        for( uti::ssize_t frame = 0; frame < frames; ++frame )
+        {
+                run_frame( warmup_frames + frame, opts.rate_hz, tr, samples, frame ) ;
+
+                deadline += period ;
+
+                if( monotonic_now() > deadline ) ++late ;
+                else                             sleep_until( deadline ) ;
+        }
+        nanoseconds_t const elapsed = monotonic_now() - start ;
+
+        fire_event( SCS_TELEMETRY_EVENT_paused, nullptr ) ;
+        shutdown() ;
+
+        print_summary( stdout, "frame_start", summarize( samples.frame_start, frames ) ) ;
+        print_summary( stdout, "channels"   , summarize( samples.channels   , frames ) ) ;
+        print_summary( stdout, "frame_end"  , summarize( samples.frame_end  , frames ) ) ;
+        print_summary( stdout, "frame"      , summarize( samples.total      , frames ) ) ;
+
+        for( uti::ssize_t i = 0; i < g_host.channel_count; ++i )
+        {
+                registered_channel & channel = g_host.channels[ i ] ;
+
+                char label [ FFFB_HOST_NAME_LEN + 16 ] ;
+
+                if( channel.index == SCS_U32_NIL ) snprintf( label, sizeof( label ), "  %s", channel.name ) ;
+                else                               snprintf( label, sizeof( label ), "  %s[%u]", channel.name, channel.index ) ;
+
+                print_summary( stdout, label, summarize( channel.samples, frames ) ) ;
+        }
+        printf( "%-20s %.1f frames/s of %ld requested, %ld late\n", "rate", per_second( frames, elapsed ), static_cast< long >( opts.rate_hz ), static_cast< long >( late ) ) ;
+
+        for( uti::ssize_t i = 0; i < g_host.channel_count; ++i ) free( g_host.channels[ i ].samples ) ;
+
+        free( samples.frame_start ) ;
+        free( samples.channels    ) ;
+        free( samples.frame_end   ) ;
+        free( samples.total       ) ;
+        free( tr.values           ) ;
+
+        dlclose( plugin ) ;
+        return 0 ;
+}
@@ -0,0 +1,446 @@
+//
+//
+//      fffb
+//      tools/uhid_wheel/uhid_wheel.cxx
+//
+
+// a virtual g29 created through /dev/uhid, so wheel, protocol and the hidraw backend can be exercised without hardware.
+// the device is put on the virtual bus so hid-logitech leaves it to hid-generic and it shows up as a plain hidraw node.
+//
+//      fffb_uhid_wheel serve                  print every output report the device receives
+//      fffb_uhid_wheel latency    [count]     round trip constant force refreshes through fffb::wheel
+//      fffb_uhid_wheel throughput [count]     burst refreshes and time until all of them arrived
+//
+// needs read/write access to /dev/uhid and to the hidraw node it creates
+
+#include <fffb/util/types.hxx>
+#include <fffb/util/clock.hxx>
+#include <fffb/util/seqlock.hxx>
+#include <fffb/joy/wheel.hxx>
+
+#include <common/report_decode.hxx>
+#include <common/stats.hxx>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <linux/uhid.h>
+#include <linux/input.h>
+
+#define FFFB_UHID_PATH             "/dev/uhid"
+#define FFFB_UHID_NAME             "fffb virtual G29 Driving Force Racing Wheel"
+#define FFFB_UHID_DEFAULT_COUNT    10000
+#define FFFB_UHID_NODE_TIMEOUT_NS  ( 5ull * fffb::ns_per_sec )
+#define FFFB_UHID_REPLY_TIMEOUT_NS ( 1ull * fffb::ns_per_sec )
+
+
+namespace fffb::tools
+{
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the parts of the g29 descriptor fffb cares about: generic desktop / joystick as primary usage,
+// the wheel axis and pedals as inputs and an 8 byte vendor output report with no report id
+
+constexpr uti::u8_t g29_report_descriptor [] =
+{
+        0x05, 0x01,             // usage page (generic desktop)
+        0x09, 0x04,             // usage (joystick)
+        0xA1, 0x01,             // collection (application)
+        0x09, 0x30,             //   usage (x)
+        0x15, 0x00,             //   logical minimum (0)
+        0x27, 0xFF, 0xFF, 0x00, //   logical maximum (65535)
+        0x75, 0x10,             //   report size (16)
+        0x95, 0x01,             //   report count (1)
+        0x81, 0x02,             //   input (data, var, abs)
+        0x09, 0x31,             //   usage (y)
+        0x09, 0x32,             //   usage (z)
+        0x09, 0x35,             //   usage (rz)
+        0x26, 0xFF, 0x00,       //   logical maximum (255)
+        0x75, 0x08,             //   report size (8)
+        0x95, 0x03,             //   report count (3)
+        0x81, 0x02,             //   input (data, var, abs)
+        0x06, 0x00, 0xFF,       //   usage page (vendor defined)
+        0x09, 0x01,             //   usage (1)
+        0x95, 0x08,             //   report count (8)
+        0x75, 0x08,             //   report size (8)
+        0x91, 0x02,             //   output (data, var, abs)
+        0xC0,                   // end collection
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct received_report
+{
+        nanoseconds_t arrival ;
+        report           data ;
+} ;
+
+class uhid_wheel
+{
+public:
+        constexpr  uhid_wheel () noexcept = default ;
+        constexpr ~uhid_wheel () noexcept { destroy() ; }
+
+        uhid_wheel             ( uhid_wheel const & ) = delete ;
+        uhid_wheel & operator= ( uhid_wheel const & ) = delete ;
+
+        constexpr bool  create () noexcept ;
+        constexpr void destroy () noexcept ;
+
+        // blocks until a matching hidraw node is visible to fffb's discovery
+        [[ nodiscard ]] constexpr bool wait_for_node ( nanoseconds_t timeout ) const noexcept ;
+
+        void set_verbose ( bool const verbose ) noexcept { verbose_ = verbose ; }
+
+        [[ nodiscard ]] uti::u64_t received () const noexcept { return last_.generation() ; }
+
+        [[ nodiscard ]] received_report last () const noexcept { return last_.load() ; }
+private:
+        int fd_ { -1 } ;
+
+        pthread_t thread_ {} ;
+
+        bool verbose_ { false } ;
+
+        std::atomic< bool > running_ { false } ;
+
+        // written only by the reader thread, its generation doubles as the received count
+        seqlock< received_report > last_ ;
+
+        constexpr bool _send ( uhid_event const & event ) const noexcept ;
+
+        void _handle ( uhid_event const & event ) noexcept ;
+
+        static void * _run ( void * _self_ ) noexcept ;
+} ;
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool uhid_wheel::create () noexcept
+{
+        fd_ = ::open( FFFB_UHID_PATH, O_RDWR | O_CLOEXEC ) ;
+
+        if( fd_ < 0 )
+        {
+                fprintf( stderr, "uhid_wheel: failed opening " FFFB_UHID_PATH ": %s\n", strerror( errno ) ) ;
+                return false ;
+        }
+        uhid_event event {} ;
+
+        event.type = UHID_CREATE2 ;
+
+        snprintf( reinterpret_cast< char * >( event.u.create2.name ), sizeof( event.u.create2.name ), "%s", FFFB_UHID_NAME ) ;
+        snprintf( reinterpret_cast< char * >( event.u.create2.phys ), sizeof( event.u.create2.phys ), "fffb/uhid" ) ;
+
+        event.u.create2.rd_size = sizeof( g29_report_descriptor ) ;
+        event.u.create2.bus     = BUS_VIRTUAL ;
+        event.u.create2.vendor  = Logitech_VendorID ;
+        event.u.create2.product = Logitech_G29_PS4_DeviceID >> 16 ;
+        event.u.create2.version = 0x0111 ;
+        event.u.create2.country = 0 ;
+
+        memcpy( event.u.create2.rd_data, g29_report_descriptor, sizeof( g29_report_descriptor ) ) ;
+
+        if( !_send( event ) )
+        {
+                ::close( fd_ ) ;
+                fd_ = -1 ;
+                return false ;
+        }
+        running_.store( true, std::memory_order_release ) ;
+
+        if( pthread_create( &thread_, nullptr, _run, this ) != 0 )
+        {
+                fprintf( stderr, "uhid_wheel: failed spawning reader thread\n" ) ;
+                running_.store( false, std::memory_order_release ) ;
+                destroy() ;
+                return false ;
+        }
+        return true ;
+}
+
+constexpr void uhid_wheel::destroy () noexcept
+{
+        if( fd_ < 0 ) return ;
+
+        if( running_.exchange( false, std::memory_order_acq_rel ) ) pthread_join( thread_, nullptr ) ;
+
+        uhid_event event {} ;
+        event.type = UHID_DESTROY ;
+
+        ( void ) _send( event ) ;
+
+        ::close( fd_ ) ;
+        fd_ = -1 ;
+}
+
+constexpr bool uhid_wheel::wait_for_node ( nanoseconds_t const timeout ) const noexcept
+{
+        nanoseconds_t const deadline = monotonic_now() + timeout ;
+
+        while( monotonic_now() < deadline )
+        {
+                for( auto const & device : find_hid_devices( FFFB_WHEEL_USAGE_PAGE, FFFB_WHEEL_USAGE, Logitech_VendorID ) )
+                {
+                        if( device.device_id() == Logitech_G29_PS4_DeviceID ) return true ;
+                }
+                sleep_until( monotonic_now() + ns_per_sec / 100 ) ;
+        }
+        fprintf( stderr, "uhid_wheel: no hidraw node appeared, is hid-generic loaded and is the node accessible?\n" ) ;
+        return false ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr bool uhid_wheel::_send ( uhid_event const & event ) const noexcept
+{
+        ::ssize_t written ;
+
+        do { written = ::write( fd_, &event, sizeof( event ) ) ; } while( written < 0 && errno == EINTR ) ;
+
+        if( written != static_cast< ::ssize_t >( sizeof( event ) ) )
+        {
+                fprintf( stderr, "uhid_wheel: failed writing uhid event %u: %s\n", event.type, strerror( errno ) ) ;
+                return false ;
+        }
+        return true ;
+}
+
+void uhid_wheel::_handle ( uhid_event const & event ) noexcept
+{
+        switch( event.type )
+        {
+                case UHID_OUTPUT:
+                {
+                        nanoseconds_t const arrival = monotonic_now() ;
+
+                        uti::u8_t const * data = event.u.output.data ;
+                        uti::u16_t        size = event.u.output.size ;
+
+                        // hidraw keeps the zero report id in front of unnumbered reports
+                        if( size == sizeof( report::data ) + 1 && data[ 0 ] == 0 ) { ++data ; --size ; }
+
+                        if( size != sizeof( report::data ) )
+                        {
+                                fprintf( stderr, "uhid_wheel: ignoring output report of %u bytes\n", size ) ;
+                                return ;
+                        }
+                        received_report rec { arrival, {} } ;
+                        memcpy( rec.data.data, data, size ) ;
+
+                        last_.store( rec ) ;
+
+                        if( verbose_ )
+                        {
+                                char line [ 128 ] ;
+                                describe_report( rec.data, line, sizeof( line ) ) ;
+
+                                printf( "%llu.%.9llu  %s\n", static_cast< unsigned long long >( arrival / ns_per_sec ),
+                                                             static_cast< unsigned long long >( arrival % ns_per_sec ), line ) ;
+                                fflush( stdout ) ;
+                        }
+                        return ;
+                }
+                case UHID_START : if( verbose_ ) printf( "device started\n" ) ; return ;
+                case UHID_STOP  : if( verbose_ ) printf( "device stopped\n" ) ; return ;
+                case UHID_OPEN  : if( verbose_ ) printf( "device opened\n"  ) ; return ;
+                case UHID_CLOSE : if( verbose_ ) printf( "device closed\n"  ) ; return ;
+                case UHID_GET_REPORT:
+                {
+                        uhid_event reply {} ;
+                        reply.type                 = UHID_GET_REPORT_REPLY ;
+                        reply.u.get_report_reply.id  = event.u.get_report.id ;
+                        reply.u.get_report_reply.err = EIO ;
+                        ( void ) _send( reply ) ;
+                        return ;
+                }
+                case UHID_SET_REPORT:
+                {
+                        uhid_event reply {} ;
+                        reply.type                 = UHID_SET_REPORT_REPLY ;
+                        reply.u.set_report_reply.id  = event.u.set_report.id ;
+                        reply.u.set_report_reply.err = 0 ;
+                        ( void ) _send( reply ) ;
+                        return ;
+                }
+                default: return ;
+        }
+}
+
+void * uhid_wheel::_run ( void * _self_ ) noexcept
+{
+        uhid_wheel * self = static_cast< uhid_wheel * >( _self_ ) ;
+
+        uhid_event event ;
+
+        while( self->running_.load( std::memory_order_acquire ) )
+        {
+                pollfd pfd { self->fd_, POLLIN, 0 } ;
+
+                if( poll( &pfd, 1, 100 ) <= 0 ) continue ;
+
+                ::ssize_t const len = ::read( self->fd_, &event, sizeof( event ) ) ;
+
+                if( len <= 0 ) continue ;
+
+                self->_handle( event ) ;
+        }
+        return nullptr ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static std::atomic< bool > g_interrupted { false } ;
+
+int serve ( uhid_wheel & device ) noexcept
+{
+        device.set_verbose( true ) ;
+
+        signal( SIGINT , []( int ){ g_interrupted.store( true ) ; } ) ;
+        signal( SIGTERM, []( int ){ g_interrupted.store( true ) ; } ) ;
+
+        printf( "serving " FFFB_UHID_NAME ", ctrl-c to stop\n" ) ;
+
+        while( !g_interrupted.load() ) sleep_until( monotonic_now() + ns_per_sec / 10 ) ;
+
+        printf( "received %llu reports\n", static_cast< unsigned long long >( device.received() ) ) ;
+        return 0 ;
+}
+
+[[ nodiscard ]] bool prepare_wheel ( wheel & whl ) noexcept
+{
+        if( !whl.connect() ) return false ;
+
+        whl.disable_autocenter() ;
+
+        whl.constant_force().enabled   = true ;
+        whl.constant_force().amplitude = 0x80 ;
+
+        return whl.download_forces() && whl.play_forces() ;
+}
+
+// the amplitude walks through every value but never repeats back to back, so the wheel's dedup never swallows a refresh
+constexpr uti::u8_t amplitude_for ( uti::ssize_t const i ) noexcept { return static_cast< uti::u8_t >( 1 + i % 254 ) ; }
+
+int latency ( uhid_wheel & device, uti::ssize_t const count ) noexcept
+{
+        wheel whl ;
+
+        if( !prepare_wheel( whl ) ) return 1 ;
+
+        nanoseconds_t * samples = static_cast< nanoseconds_t * >( malloc( count * sizeof( nanoseconds_t ) ) ) ;
+        uti::ssize_t    missing { 0 } ;
+        uti::ssize_t    taken   { 0 } ;
+
+        nanoseconds_t const start = monotonic_now() ;
+
+        for( uti::ssize_t i = 0; i < count; ++i )
+        {
+                uti::u8_t  const amplitude = amplitude_for( i ) ;
+                uti::u64_t const before    = device.received() ;
+
+                whl.constant_force().amplitude = amplitude ;
+
+                nanoseconds_t const sent = monotonic_now() ;
+
+                whl.refresh_forces() ;
+
+                nanoseconds_t const deadline = sent + FFFB_UHID_REPLY_TIMEOUT_NS ;
+
+                bool seen { false } ;
+
+                while( !seen && monotonic_now() < deadline )
+                {
+                        if( device.received() == before ) continue ;
+
+                        received_report const rec = device.last() ;
+
+                        seen = ( rec.data[ 0 ] & 0x0F ) == 0x0C && rec.data[ 1 ] == 0x00 && rec.data[ 2 ] == amplitude ;
+
+                        if( seen ) samples[ taken++ ] = rec.arrival - sent ;
+                }
+                if( !seen ) ++missing ;
+        }
+        nanoseconds_t const elapsed = monotonic_now() - start ;
+
+        latency_summary const summary = summarize( samples, taken ) ;
+
+        print_summary( stdout, "write->arrival", summary ) ;
+        printf( "%-20s %.0f round trips/s, %ld missing\n", "rate", per_second( taken, elapsed ), static_cast< long >( missing ) ) ;
+
+        free( samples ) ;
+        return missing == 0 ? 0 : 2 ;
+}
+
+int throughput ( uhid_wheel & device, uti::ssize_t const count ) noexcept
+{
+        wheel whl ;
+
+        if( !prepare_wheel( whl ) ) return 1 ;
+
+        uti::u64_t const before = device.received() ;
+
+        nanoseconds_t const start = monotonic_now() ;
+
+        for( uti::ssize_t i = 0; i < count; ++i )
+        {
+                whl.constant_force().amplitude = amplitude_for( i ) ;
+                whl.refresh_forces() ;
+        }
+        nanoseconds_t const written = monotonic_now() ;
+
+        uti::u64_t const expected = before + static_cast< uti::u64_t >( count ) ;
+
+        while( device.received() < expected && monotonic_now() - written < FFFB_UHID_REPLY_TIMEOUT_NS ) {}
+
+        nanoseconds_t const elapsed = device.last().arrival - start ;
+        uti::u64_t    const arrived = device.received() - before ;
+
+        printf( "%-20s %.0f reports/s\n", "write rate"  , per_second( count  , written - start ) ) ;
+        printf( "%-20s %.0f reports/s\n", "arrival rate", per_second( arrived, elapsed         ) ) ;
+        printf( "%-20s %llu of %ld\n"   , "arrived", static_cast< unsigned long long >( arrived ), static_cast< long >( count ) ) ;
+
+        return arrived == static_cast< uti::u64_t >( count ) ? 0 : 2 ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+} // namespace fffb::tools
+
+
+int main ( int argc, char ** argv )
+{
+        using namespace fffb::tools ;
+
+        char const * mode = argc > 1 ? argv[ 1 ] : "serve" ;
+
+        uti::ssize_t const count = argc > 2 ? atol( argv[ 2 ] ) : FFFB_UHID_DEFAULT_COUNT ;
+
+        if( count <= 0 )
+        {
+                fprintf( stderr, "usage: %s [serve | latency [count] | throughput [count]]\n", argv[ 0 ] ) ;
+                return 1 ;
+        }
+        uhid_wheel device ;
+
+        if( !device.create() ) return 1 ;
+
+        if( !device.wait_for_node( FFFB_UHID_NODE_TIMEOUT_NS ) ) return 1 ;
+
+        if( strcmp( mode, "serve"      ) == 0 ) return serve     ( device        ) ;
+        if( strcmp( mode, "latency"    ) == 0 ) return latency   ( device, count ) ;
+        if( strcmp( mode, "throughput" ) == 0 ) return throughput( device, count ) ;
+
+        fprintf( stderr, "usage: %s [serve | latency [count] | throughput [count]]\n", argv[ 0 ] ) ;
+        return 1 ;
+}